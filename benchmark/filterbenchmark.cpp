@@ -0,0 +1,390 @@
+#include "filefilterutil.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+
+namespace {
+// 合成路径集合的默认条目数
+const int DefaultEntryCount = 200000;
+// 每个场景默认重复的遍数，取总用时的平均值
+const int DefaultIterations = 5;
+// 合成路径集合的根目录
+const char *const SyntheticRoot = "/benchmark/root/";
+
+// 计时区间内的内存分配次数
+std::atomic<quint64> allocationCount{0};
+}
+
+// glibc下替换malloc系列函数，QString等Qt容器的分配也会被统计；
+// 其他平台只能替换operator new，Qt容器的分配不在统计之内
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+#define FILTERBENCHMARK_COUNTS_MALLOC
+#else
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+#endif
+
+namespace {
+/**
+ * @brief 一组待过滤的路径
+ */
+struct Corpus {
+    QString name;                               ///< 名称，用于报告
+    QVector<QString> paths;                     ///< 规范化的路径，目录以'/'结尾
+    QVector<FileFilterUtil::EntryKind> kinds;   ///< 每个路径的条目类型
+    int relativeStart = 0;                      ///< 相对于根目录的部分的起始下标
+};
+
+/**
+ * @brief 一组过滤规则
+ */
+struct Scenario {
+    QString name;                               ///< 名称，用于报告
+    QList<FileFilterUtil::FilterRule> rules;    ///< 过滤规则列表
+};
+
+// 确定性的线性同余随机数，保证每次生成相同的合成路径
+class Random
+{
+public:
+    int next(int bound)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<int>((state >> 33) % static_cast<quint64>(bound));
+    }
+
+private:
+    quint64 state = 0x2545F4914F6CDD1DULL;
+};
+
+// 生成合成路径：约十分之一为目录，目录名和扩展名的分布模仿常见的源码仓库
+Corpus syntheticCorpus(int entryCount)
+{
+    static const char *const directoryNames[] = {
+        "src", "include", "lib", "test", "tests", "docs", "build", "node_modules", ".git", "generated",
+        "core", "utils", "platform", "third_party", "assets", "scripts", "examples", "internal"
+    };
+    static const char *const fileNames[] = {
+        "main", "README", "CMakeLists", "config", "utils", "test_parser", "index", "module", "logger",
+        "filefilterutil", "directorytreereader", "package", "settings", "LICENSE", "Makefile"
+    };
+    static const char *const extensions[] = {
+        ".cpp", ".h", ".hpp", ".c", ".py", ".md", ".txt", ".o", ".obj", ".log", ".json", ".png", ".tmp",
+        ".js", ".ts", ".cmake", ""
+    };
+
+    Corpus corpus;
+    corpus.name = QString("合成(%1)").arg(entryCount);
+    corpus.relativeStart = static_cast<int>(qstrlen(SyntheticRoot));
+    corpus.paths.reserve(entryCount);
+    corpus.kinds.reserve(entryCount);
+
+    Random random;
+    QVector<QString> directories = {QString::fromLatin1(SyntheticRoot)};
+    for (int i = 0; i < entryCount; ++i) {
+        const QString &parent = directories.at(random.next(static_cast<int>(directories.size())));
+        const bool directory = random.next(10) == 0 && parent.count('/') < 12;
+        QString path = parent;
+        if (directory) {
+            path += QString::fromLatin1(directoryNames[random.next(static_cast<int>(std::size(directoryNames)))]);
+            path += QString::number(random.next(4));
+            path += '/';
+            directories.append(path);
+        } else {
+            path += QString::fromLatin1(fileNames[random.next(static_cast<int>(std::size(fileNames)))]);
+            path += QString::number(random.next(100));
+            path += QString::fromLatin1(extensions[random.next(static_cast<int>(std::size(extensions)))]);
+        }
+        corpus.paths.append(path);
+        corpus.kinds.append(directory ? FileFilterUtil::EntryKind::Directory : FileFilterUtil::EntryKind::File);
+    }
+    return corpus;
+}
+
+// 读取记录的路径：aidoctools export输出的NDJSON，或每行一个路径的文本（目录以/结尾）；
+// NDJSON中深度为0的记录是根目录，否则以所有路径共同的父目录作为根目录
+bool loadCorpus(const QString &fileName, Corpus &corpus)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    corpus.name = QFileInfo(fileName).fileName();
+    QString root;
+    bool rootRecord = false;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QString path;
+        bool directory;
+        if (line.startsWith('{')) {
+            const QJsonObject record = QJsonDocument::fromJson(line).object();
+            path = record.value("path").toString();
+            directory = record.value("type").toString() == "directory";
+            if (record.value("depth").toInt(-1) == 0) {
+                root = FileFilterUtil::normalizePath(path, FileFilterUtil::EntryKind::Directory);
+                rootRecord = true;
+                continue;
+            }
+        } else {
+            path = QString::fromUtf8(line);
+            directory = path.endsWith('/') || path.endsWith('\\');
+        }
+        if (path.isEmpty()) {
+            continue;
+        }
+
+        const FileFilterUtil::EntryKind kind = directory ? FileFilterUtil::EntryKind::Directory
+                                                         : FileFilterUtil::EntryKind::File;
+        path = FileFilterUtil::normalizePath(path, kind);
+        if (!rootRecord) {
+            if (corpus.paths.isEmpty()) {
+                root = path.left(path.lastIndexOf('/', path.size() - 2) + 1);
+            }
+            while (!root.isEmpty() && !path.startsWith(root)) {
+                root.truncate(root.size() > 1 ? root.lastIndexOf('/', root.size() - 2) + 1 : 0);
+            }
+        }
+        corpus.paths.append(path);
+        corpus.kinds.append(kind);
+    }
+    corpus.relativeStart = static_cast<int>(root.size());
+    return true;
+}
+
+// 没有通过命令行指定规则时使用的典型规则集
+QList<Scenario> defaultScenarios()
+{
+    using Rule = FileFilterUtil::FilterRule;
+    const auto wildcard = FileFilterUtil::MatchType::Wildcard;
+    const auto regex = FileFilterUtil::MatchType::Regex;
+    const auto gitignore = FileFilterUtil::MatchType::Gitignore;
+    const auto include = FileFilterUtil::FilterMode::Include;
+    const auto exclude = FileFilterUtil::FilterMode::Exclude;
+
+    QList<Scenario> scenarios;
+    scenarios.append({"无规则", {}});
+    scenarios.append({"常用排除", {
+        Rule(".git/", wildcard, exclude), Rule("node_modules/", wildcard, exclude), Rule("*.o", wildcard, exclude),
+        Rule("*.obj", wildcard, exclude), Rule("*.log", wildcard, exclude), Rule("*.tmp", wildcard, exclude),
+        Rule("third_party/", wildcard, exclude), Rule("*generated*", wildcard, exclude),
+        Rule("test_*", wildcard, exclude), Rule("README*", wildcard, exclude)
+    }});
+
+    Scenario extensions{"扩展名包含", {
+        Rule("*.cpp", wildcard, include), Rule("*.h", wildcard, include), Rule("*.hpp", wildcard, include),
+        Rule("*.md", wildcard, include), Rule("CMakeLists*", wildcard, include)
+    }};
+    for (int i = 0; i < 300; ++i) {
+        extensions.rules.append(Rule(QString("*.ext%1").arg(i), wildcard, include));
+    }
+    scenarios.append(extensions);
+
+    scenarios.append({"正则表达式", {
+        Rule(R"(\.(o|obj|a|lib)$)", regex, exclude), Rule(R"(/test_[^/]*\.cpp$)", regex, exclude),
+        Rule(R"((^|/)\.git/)", regex, exclude), Rule(R"(/src\d/.*\.(cpp|h)$)", regex, exclude)
+    }});
+    scenarios.append({"gitignore", {
+        Rule("*.o", gitignore, exclude), Rule("/build*/", gitignore, exclude), Rule("**/generated*/**", gitignore, exclude),
+        Rule("!main1.o", gitignore, exclude), Rule("logs/", gitignore, exclude), Rule("*.tmp", gitignore, exclude),
+        Rule("docs/**/*.png", gitignore, exclude)
+    }});
+    return scenarios;
+}
+
+// 按命令行选项组成的规则集
+Scenario commandLineScenario(const QCommandLineParser &parser)
+{
+    FileFilterUtil::MatchType matchType = FileFilterUtil::MatchType::Wildcard;
+    if (parser.isSet("regex")) {
+        matchType = FileFilterUtil::MatchType::Regex;
+    } else if (parser.isSet("gitignore")) {
+        matchType = FileFilterUtil::MatchType::Gitignore;
+    }
+
+    Scenario scenario{"命令行规则", {}};
+    for (const QString &pattern : parser.values("exclude")) {
+        scenario.rules.append(FileFilterUtil::FilterRule(pattern, matchType, FileFilterUtil::FilterMode::Exclude));
+    }
+    for (const QString &pattern : parser.values("include")) {
+        scenario.rules.append(FileFilterUtil::FilterRule(pattern, matchType, FileFilterUtil::FilterMode::Include));
+    }
+    return scenario;
+}
+
+// 过滤一遍路径集合，返回包含的条目数
+qsizetype filterCorpus(const FileFilterUtil &filter, const Corpus &corpus)
+{
+    qsizetype included = 0;
+    for (qsizetype i = 0; i < corpus.paths.size(); ++i) {
+        if (filter.shouldInclude(corpus.paths.at(i), corpus.kinds.at(i), corpus.relativeStart)) {
+            ++included;
+        }
+    }
+    return included;
+}
+
+void runScenario(const Scenario &scenario, const Corpus &corpus, int iterations, bool profile)
+{
+    FileFilterUtil filter;
+    filter.setFilterRules(scenario.rules);
+
+    // 先过滤一遍预热，线程局部缓冲区和正则表达式的JIT在计时之前就绪
+    const qsizetype included = filterCorpus(filter, corpus);
+
+    const quint64 allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        filterCorpus(filter, corpus);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    const quint64 allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+    const double entries = static_cast<double>(corpus.paths.size()) * iterations;
+    std::printf("%-12s %-24s %9lld %9lld %10.1f %10.3f\n", qUtf8Printable(scenario.name),
+                qUtf8Printable(corpus.name), static_cast<long long>(corpus.paths.size()),
+                static_cast<long long>(included), entries > 0 ? elapsed / entries : 0.0,
+                entries > 0 ? allocations / entries : 0.0);
+
+    if (!profile || scenario.rules.isEmpty()) {
+        return;
+    }
+
+    // 统计需要计时，单独再过滤一遍，不影响上面的结果
+    FileFilterUtil::setProfilingEnabled(true);
+    filter.setFilterRules(scenario.rules);
+    filterCorpus(filter, corpus);
+    FileFilterUtil::setProfilingEnabled(false);
+
+    const QVector<FileFilterUtil::RuleStatistics> statistics = filter.ruleStatistics();
+    for (int i = 0; i < scenario.rules.size(); ++i) {
+        const FileFilterUtil::RuleStatistics &rule = statistics.at(i);
+        std::printf("    %-32s 命中 %9llu  未命中 %9llu  %10.3f ms\n", qUtf8Printable(scenario.rules.at(i).pattern),
+                    static_cast<unsigned long long>(rule.hits), static_cast<unsigned long long>(rule.misses),
+                    rule.nanoseconds / 1000000.0);
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("过滤规则基准测试：报告每个条目的平均用时和内存分配次数");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("corpus", "记录的路径列表：export输出的NDJSON或每行一个路径（可重复）", "file"));
+    parser.addOption(QCommandLineOption("entries", "合成路径的条目数，为0时不生成", "n",
+                                        QString::number(DefaultEntryCount)));
+    parser.addOption(QCommandLineOption("iterations", "每个场景重复的遍数", "n", QString::number(DefaultIterations)));
+    parser.addOption(QCommandLineOption("exclude", "排除规则（可重复），指定规则时不再使用内置的规则集", "pattern"));
+    parser.addOption(QCommandLineOption("include", "包含规则（可重复）", "pattern"));
+    parser.addOption(QCommandLineOption("regex", "--exclude/--include按正则表达式匹配，默认为通配符"));
+    parser.addOption(QCommandLineOption("gitignore", "--exclude/--include按gitignore语法匹配"));
+    parser.addOption(QCommandLineOption("profile", "另外输出每条规则的命中次数、未命中次数和用时"));
+    parser.process(app);
+
+    QList<Corpus> corpora;
+    const int entryCount = parser.value("entries").toInt();
+    if (entryCount > 0) {
+        corpora.append(syntheticCorpus(entryCount));
+    }
+    for (const QString &fileName : parser.values("corpus")) {
+        Corpus corpus;
+        if (!loadCorpus(fileName, corpus)) {
+            std::fprintf(stderr, "%s\n", qUtf8Printable(QString("无法读取路径列表: %1").arg(fileName)));
+            return 1;
+        }
+        corpora.append(corpus);
+    }
+
+    const QList<Scenario> scenarios = parser.isSet("exclude") || parser.isSet("include")
+        ? QList<Scenario>{commandLineScenario(parser)}
+        : defaultScenarios();
+    const int iterations = qMax(1, parser.value("iterations").toInt());
+
+#ifdef FILTERBENCHMARK_COUNTS_MALLOC
+    std::printf("分配次数：malloc/calloc/realloc\n");
+#else
+    std::printf("分配次数：仅operator new（不含Qt容器）\n");
+#endif
+    std::printf("%-12s %-24s %9s %9s %10s %10s\n", "规则集", "路径集合", "条目", "包含", "ns/条目", "分配/条目");
+    for (const Corpus &corpus : corpora) {
+        for (const Scenario &scenario : scenarios) {
+            runScenario(scenario, corpus, iterations, parser.isSet("profile"));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file commandlinetool.h
+ * @brief 命令行模式的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef COMMANDLINETOOL_H
+#define COMMANDLINETOOL_H
+
+#include "filefilterutil.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QList>
+#include <QStringList>
+
+class DirectoryTreeReader;
+
+/**
+ * @class CommandLineTool
+ * @brief 不创建任何窗口部件的命令行模式
+ *
+ * 以子命令的形式驱动DirectoryTreeReader和FileMerger，选项与界面中的一一对应：
+ * - scan：读取目录树并输出统计信息（目录数、文件数、用时）
+ * - tree：读取目录树并输出文本表示
+ * - export：读取目录树，边读取边输出NDJSON、嵌套JSON或CSV记录
+ * - merge：搜索并合并文本文件
+ *
+ * 结果写入标准输出或-o指定的文件，便于在批处理中使用和重复计时。
+ * 需要在QCoreApplication中运行，读取器和合并器的结果通过事件循环送达。
+ */
+class CommandLineTool
+{
+public:
+    /**
+     * @brief 判断启动参数是否为命令行模式
+     * @param argc 参数个数
+     * @param argv 参数列表
+     * @return 第一个参数是子命令时返回true
+     */
+    static bool isCommandLine(int argc, char *argv[]);
+
+    /**
+     * @brief 解析参数并执行子命令
+     * @param arguments 完整的启动参数（含程序名）
+     * @return 进程退出码
+     */
+    int run(const QStringList &arguments);
+
+private:
+    /**
+     * @brief 退出码
+     */
+    enum ExitCode {
+        Success = 0,        ///< 成功
+        UsageError = 1,     ///< 参数错误
+        RuntimeError = 2    ///< 目录不存在或输出失败
+    };
+
+    QCommandLineParser parser;  ///< 参数解析器
+
+    /**
+     * @brief 添加scan和tree共用的选项
+     */
+    void addTreeOptions();
+
+    /**
+     * @brief 添加merge的选项
+     */
+    void addMergeOptions();
+
+    /**
+     * @brief 执行scan或tree
+     * @param rootPath 根目录路径
+     * @param renderTree 为true时输出文本表示，否则输出统计信息
+     * @return 退出码
+     */
+    int runTree(const QString &rootPath, bool renderTree);
+
+    /**
+     * @brief 执行export
+     * @param rootPath 根目录路径
+     * @return 退出码
+     */
+    int runExport(const QString &rootPath);
+
+    /**
+     * @brief 执行merge
+     * @param rootPath 根目录路径
+     * @return 退出码
+     */
+    int runMerge(const QString &rootPath);
+
+    /**
+     * @brief 按scan/tree/export共用的选项设置读取器
+     * @param reader 读取器
+     * @param depth 最大搜索深度
+     */
+    void configureReader(DirectoryTreeReader &reader, int depth) const;
+
+    /**
+     * @brief 开始读取并在本地事件循环中等待读取完成
+     * @param reader 读取器
+     * @param rootPath 根目录路径
+     */
+    static void readAndWait(DirectoryTreeReader &reader, const QString &rootPath);
+
+    /**
+     * @brief 由--exclude/--include选项生成过滤规则
+     * @return 过滤规则列表
+     */
+    QList<FileFilterUtil::FilterRule> filterRules() const;
+
+    /**
+     * @brief 打开输出设备
+     * @param output 输出文件，未指定-o时绑定到标准输出
+     * @return 是否成功打开
+     */
+    bool openOutput(QFile &output) const;
+
+    /**
+     * @brief 读取--depth选项
+     * @param depth 输出的深度
+     * @return 选项值有效时返回true
+     */
+    bool readDepth(int &depth) const;
+
+    /**
+     * @brief 在Windows上连接到启动本程序的控制台
+     */
+    static void attachConsole();
+
+    /**
+     * @brief 向标准错误输出一行信息
+     * @param message 信息
+     */
+    static void printError(const QString &message);
+};
+
+#endif // COMMANDLINETOOL_H
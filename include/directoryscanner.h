@@ -0,0 +1,118 @@
+/**
+ * @file directoryscanner.h
+ * @brief 目录扫描后端的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDateTime>
+#include <QHashFunctions>
+
+/**
+ * @class DirectoryScanner
+ * @brief 目录扫描后端
+ *
+ * 在Linux上直接使用openat/getdents64读取目录，依靠d_type区分文件和目录，
+ * 只有d_type无法确定类型（符号链接或DT_UNKNOWN）时才对单个条目调用stat。
+ * 文件大小、修改时间等元数据默认不在扫描时获取，需要时可以在扫描时顺带查询文件条目的元数据，
+ * 或者通过queryMetadata()用statx单独查询。
+ * 其他平台回退到QDir实现。
+ *
+ * 返回的条目与QDir::entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot)一致：
+ * 不包含隐藏条目和系统条目（设备、管道、失效的符号链接），按名称不区分大小写排序。
+ * 隐藏的忽略文件（见IgnoreStack::fileNames()）不放入条目列表，但可以在同一次读取中单独取得。
+ */
+class DirectoryScanner
+{
+public:
+    /**
+     * @brief 条目类型
+     */
+    enum class EntryType : quint8 {
+        File,       ///< 普通文件
+        Directory   ///< 目录
+    };
+
+    /**
+     * @brief 文件标识（设备号和inode号），inode为0表示未知
+     */
+    struct FileId {
+        quint64 device; ///< 设备号
+        quint64 inode;  ///< inode号
+
+        FileId() : device(0), inode(0) {}
+        FileId(quint64 d, quint64 i) : device(d), inode(i) {}
+
+        bool isValid() const { return inode != 0; }
+        bool operator==(const FileId &other) const { return device == other.device && inode == other.inode; }
+    };
+
+    /**
+     * @brief 目录条目
+     */
+    struct Entry {
+        QString name;       ///< 名称
+        EntryType type;     ///< 类型
+        FileId id;          ///< 文件标识（目录项直接提供，不额外调用stat；其他平台上无效）
+        qint64 size;        ///< 文件大小（字节），仅在扫描时要求元数据时填充
+        qint64 modified;    ///< 文件修改时间（自纪元起的毫秒数），仅在扫描时要求元数据时填充
+
+        Entry() : type(EntryType::File), size(0), modified(0) {}
+        Entry(const QString &n, EntryType t, const FileId &i = FileId())
+            : name(n), type(t), id(i), size(0), modified(0) {}
+
+        bool isDir() const { return type == EntryType::Directory; }
+    };
+
+    /**
+     * @brief 文件元数据
+     */
+    struct Metadata {
+        qint64 size;            ///< 文件大小（字节）
+        QDateTime lastModified; ///< 最后修改时间
+
+        Metadata() : size(0) {}
+    };
+
+    /**
+     * @brief 读取目录
+     * @param path 目录路径
+     * @param includeFiles 是否包含文件，为false时只返回目录
+     * @param entries 输出的条目列表（已排序）
+     * @param modified 非空时输出读取前目录自身的修改时间（自纪元起的毫秒数）
+     * @param directoryId 非空时输出目录自身的文件标识（经符号链接或绑定挂载到达时也是实际目录的标识）
+     * @param fileMetadata 为true时相对已打开的目录逐个查询文件条目的大小和修改时间
+     * @param ignoreFiles 非空时输出目录中存在的忽略文件名，与includeFiles无关
+     * @return 目录是否成功打开并完整读取
+     */
+    static bool scan(const QString &path, bool includeFiles, QVector<Entry> &entries,
+                     qint64 *modified = nullptr, FileId *directoryId = nullptr, bool fileMetadata = false,
+                     QStringList *ignoreFiles = nullptr);
+
+    /**
+     * @brief 查询文件元数据
+     * @param path 文件路径
+     * @param metadata 输出的元数据
+     * @return 是否查询成功
+     */
+    static bool queryMetadata(const QString &path, Metadata &metadata);
+
+    /**
+     * @brief 按与QDir相同的规则对条目排序（名称不区分大小写）
+     * @param entries 条目列表
+     */
+    static void sortEntries(QVector<Entry> &entries);
+};
+
+inline size_t qHash(const DirectoryScanner::FileId &id, size_t seed = 0)
+{
+    return qHashMulti(seed, id.device, id.inode);
+}
+
+#endif // DIRECTORYSCANNER_H
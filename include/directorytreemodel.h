@@ -0,0 +1,409 @@
+/**
+ * @file directorytreemodel.h
+ * @brief 目录树数据模型类的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef DIRECTORYTREEMODEL_H
+#define DIRECTORYTREEMODEL_H
+
+#include "scanresult.h"
+
+#include <QAbstractItemModel>
+#include <QByteArray>
+#include <QHash>
+#include <QIcon>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class DirectoryTreeModel
+ * @brief 基于扁平节点数组的目录树模型
+ *
+ * 节点保存在ScanResult中：紧凑的节点数组加上UTF-8字符串区，
+ * 同一目录的子节点在数组中连续存放。视图只会通过canFetchMore/fetchMore
+ * 逐批展开被用户展开的目录，未展开的节点不会创建任何额外对象。
+ *
+ * 排序不移动节点：只为已展开的目录按预先计算好的键（名称顺序或汇总统计）
+ * 生成一份行号到子节点的映射，其余目录不受影响。
+ */
+class DirectoryTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 节点标志位
+     */
+    enum NodeFlag : quint8 {
+        DirectoryFlag = ScanResult::DirectoryFlag,  ///< 节点是目录
+        ListedFlag = ScanResult::ListedFlag         ///< 目录的子节点范围已确定
+    };
+
+    /**
+     * @brief 列定义
+     */
+    enum Column {
+        NameColumn,         ///< 名称
+        TypeColumn,         ///< 类型
+        PathColumn,         ///< 路径
+        FileCountColumn,    ///< 文件数（仅目录）
+        SizeColumn,         ///< 大小
+        ModifiedColumn,     ///< 最新修改时间
+        ColumnCount
+    };
+
+    /**
+     * @brief 紧凑节点（20字节），与扫描结果共用同一布局
+     */
+    using Node = ScanResult::Node;
+
+    /**
+     * @brief 节点的汇总统计
+     */
+    using Rollup = ScanResult::Rollup;
+
+    /**
+     * @brief 子树已读取完成的目录的汇总统计
+     */
+    struct RollupUpdate {
+        qint32 node;        ///< 目录节点下标
+        Rollup rollup;      ///< 整个子树的合计
+    };
+
+    /**
+     * @brief 目录子节点范围
+     */
+    struct Listing {
+        qint32 directory;    ///< 目录节点下标
+        qint32 firstChild;   ///< 第一个子节点下标
+        qint32 childCount;   ///< 子节点数量
+    };
+
+    /**
+     * @brief 由扫描线程生成、在主线程追加的节点批次
+     *
+     * nodes中的节点下标从模型当前节点数开始连续编号，
+     * nameOffset相对于整个字符串区，与模型中的偏移一致。
+     */
+    struct NodeBatch {
+        QVector<Node> nodes;         ///< 新增节点
+        QByteArray names;            ///< 新增节点的名称
+        QVector<Listing> listings;   ///< 已读取完成的目录
+        QVector<Rollup> rollups;     ///< 与nodes平行的统计（未统计时为空）
+        QVector<RollupUpdate> completedRollups; ///< 子树已读取完成的目录
+    };
+
+    /**
+     * @brief 重新读取目录后得到的子条目
+     */
+    struct Child {
+        QString name;   ///< 名称
+        bool isDir;     ///< 是否为目录
+        qint64 size;    ///< 文件大小（字节）
+        qint64 modified; ///< 文件修改时间（自纪元起的毫秒数）
+    };
+
+    /**
+     * @brief 替换目录子节点的结果
+     */
+    struct ChildrenUpdate {
+        QVector<int> addedDirectories;   ///< 新出现的目录节点（尚未读取）
+        QStringList removedDirectories;  ///< 已消失的子目录名称
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit DirectoryTreeModel(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数
+     */
+    ~DirectoryTreeModel();
+
+    /**
+     * @brief 重置模型，只保留根节点
+     * @param rootName 根节点显示名称
+     * @param rootPath 根目录路径
+     */
+    void resetRoot(const QString &rootName, const QString &rootPath);
+
+    /**
+     * @brief 用已有的节点数据（例如扫描快照）替换整个模型
+     * @param rootPath 根目录路径
+     * @param nodes 节点数组，下标0为根节点
+     * @param count 节点数量
+     * @param names 名称字符串区
+     * @param nameBytes 字符串区大小
+     */
+    void loadNodes(const QString &rootPath, const Node *nodes, int count, const char *names, quint32 nameBytes);
+
+    /**
+     * @brief 导出当前目录树的紧凑副本
+     *
+     * 只包含从根节点可达的节点，按层序重新编号，同一目录的子节点保持连续，
+     * 被replaceChildren()替换掉的旧节点不会被导出。
+     *
+     * @param nodes 输出的节点数组
+     * @param names 输出的名称字符串区
+     * @param sourceNodes 输出的每个导出节点在当前模型中的下标
+     */
+    void exportNodes(QVector<Node> &nodes, QByteArray &names, QVector<int> &sourceNodes) const;
+
+    /**
+     * @brief 追加一批节点
+     * @param batch 节点批次
+     */
+    void appendBatch(const NodeBatch &batch);
+
+    /**
+     * @brief 用重新读取的结果替换一个目录的子节点
+     *
+     * 名称和类型都未变化的子节点连同其整个子树原样保留，只为新条目创建节点。
+     * 子节点会被移动到数组末尾的新连续区间，旧区间计入废弃量，废弃量超过数组的一半时
+     * 整理数组并重新编号，返回的新增目录下标已按整理后的编号给出。
+     * 目录已公开给视图时，消失的行以删除行通知视图，新公开的行以插入行通知视图，
+     * 节点移动和重新排序以行数不变的布局变化通知视图并同步更新持久索引，展开状态和选择不受影响。
+     * 启用了汇总统计时，该目录及其所有祖先的统计按子节点重新合计。
+     *
+     * @param directory 目录节点下标
+     * @param children 按显示顺序排列的子条目
+     * @return 新增的目录和消失的目录
+     */
+    ChildrenUpdate replaceChildren(int directory, const QVector<Child> &children);
+
+    /**
+     * @brief 按路径查找节点
+     * @param path 完整路径
+     * @return 节点下标，不在树中时返回-1
+     */
+    int findNode(const QString &path) const;
+
+    /**
+     * @brief 获取节点深度
+     * @param node 节点下标
+     * @return 深度，根节点为0
+     */
+    int nodeDepth(int node) const;
+
+    /**
+     * @brief 判断目录的子节点是否已读取
+     * @param node 节点下标
+     * @return 如果已读取返回true
+     */
+    bool isListed(int node) const;
+
+    /**
+     * @brief 设置扫描状态
+     * @param scanning 是否正在扫描，扫描期间未读取的目录会显示展开标记
+     */
+    void setScanning(bool scanning);
+
+    /**
+     * @brief 设置按需读取模式
+     * @param lazy 为true时未读取的目录始终显示展开标记，展开时发出listingRequested()
+     */
+    void setLazyLoading(bool lazy);
+
+    /**
+     * @brief 判断目录是否已被视图展开过
+     * @param node 节点下标
+     * @return 视图曾对该目录调用fetchMore时返回true
+     */
+    bool isFetched(int node) const;
+
+    /**
+     * @brief 判断模型是否带有汇总统计
+     * @return 有统计时返回true
+     */
+    bool hasRollups() const;
+
+    /**
+     * @brief 获取模型底层的扫描结果
+     * @return 扫描结果
+     */
+    const ScanResult &scanResult() const;
+
+    /**
+     * @brief 获取节点总数
+     * @return 节点数量
+     */
+    int nodeCount() const;
+
+    /**
+     * @brief 获取字符串区当前大小
+     * @return 字节数
+     */
+    quint32 nameBytes() const;
+
+    /**
+     * @brief 获取节点名称
+     * @param node 节点下标
+     * @return 名称
+     */
+    QString nodeName(int node) const;
+
+    /**
+     * @brief 获取节点名称的UTF-8字节（不复制，模型下一次修改前有效）
+     * @param node 节点下标
+     * @return 名称
+     */
+    QByteArray nodeNameUtf8(int node) const;
+
+    /**
+     * @brief 判断节点是否为目录
+     * @param node 节点下标
+     * @return 如果是目录返回true
+     */
+    bool isDirectory(int node) const;
+
+    /**
+     * @brief 获取子节点数量
+     * @param node 节点下标
+     * @return 子节点数量
+     */
+    int childCount(int node) const;
+
+    /**
+     * @brief 获取子节点下标
+     * @param node 节点下标
+     * @param row 子节点序号
+     * @return 子节点下标
+     */
+    int child(int node, int row) const;
+
+    /**
+     * @brief 按需拼接节点的完整路径
+     * @param node 节点下标
+     * @return 完整路径
+     */
+    QString filePath(int node) const;
+
+    /**
+     * @brief 获取索引对应的节点下标
+     * @param index 模型索引
+     * @return 节点下标，无效索引返回-1
+     */
+    int nodeFromIndex(const QModelIndex &index) const;
+
+    // QAbstractItemModel接口
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+signals:
+    /**
+     * @brief 按需读取模式下，用户展开了尚未读取的目录
+     * @param node 目录节点下标
+     */
+    void listingRequested(int node);
+
+private:
+    /**
+     * @brief 已展开目录的排序映射
+     */
+    struct ChildOrder {
+        QVector<qint32> rows;       ///< 第i行对应的子节点偏移
+        QVector<qint32> positions;  ///< 第i个子节点所在的行
+    };
+
+    ScanResult m_result;            ///< 节点数组和名称字符串区
+    QHash<qint32, qint32> m_fetched; ///< 已向视图公开的子节点数（仅限被展开的目录）
+    QHash<qint32, ChildOrder> m_childOrders; ///< 排序后的行映射（仅限被展开且需要重排的目录）
+    int m_sortColumn;               ///< 排序列（-1表示按节点顺序）
+    Qt::SortOrder m_sortOrder;      ///< 排序方向
+    bool m_scanning;                ///< 是否正在扫描
+    bool m_lazyLoading;             ///< 是否按需读取未读取的目录
+    int m_garbageNodes;             ///< 不再被引用的节点数量
+    qint64 m_garbageNameBytes;      ///< 不再被引用的名称字节数
+    mutable QIcon m_dirIcon;        ///< 目录图标缓存
+    mutable QIcon m_fileIcon;       ///< 文件图标缓存
+
+    /**
+     * @brief 获取节点对应的模型索引
+     * @param node 节点下标
+     * @param column 列号
+     * @return 模型索引，节点尚未公开给视图时返回无效索引
+     */
+    QModelIndex indexForNode(int node, int column = 0) const;
+
+    /**
+     * @brief 获取已公开的子节点数量
+     * @param node 节点下标
+     * @return 子节点数量
+     */
+    int fetchedCount(int node) const;
+
+    /**
+     * @brief 按视图中的行号获取子节点下标
+     * @param node 目录节点下标
+     * @param row 行号
+     * @return 子节点下标
+     */
+    int childAtRow(int node, int row) const;
+
+    /**
+     * @brief 判断当前排序是否与节点顺序一致（名称升序或未排序）
+     * @return 一致时返回true，此时不需要行映射
+     */
+    bool isNaturalOrder() const;
+
+    /**
+     * @brief 按当前排序重新生成一个目录的行映射
+     * @param node 目录节点下标
+     */
+    void updateChildOrder(int node);
+
+    /**
+     * @brief 设置目录公开的行，公开的行按给定顺序排在前面
+     * @param node 目录节点下标
+     * @param visible 公开的各行对应的子节点偏移
+     */
+    void setChildRows(int node, const QVector<qint32> &visible);
+
+    /**
+     * @brief 丢弃不再被引用的节点和名称，按层序重新编号并迁移持久索引
+     * @param nodes 调用方持有的节点下标，原地改为新编号
+     */
+    void compactNodes(QVector<int> &nodes);
+
+    /**
+     * @brief 重新排列若干已展开目录的子节点并迁移持久索引
+     * @param directories 目录节点下标
+     */
+    void resortDirectories(const QList<qint32> &directories);
+
+    /**
+     * @brief 设置节点的汇总统计，节点已公开时通知视图
+     * @param node 节点下标
+     * @param rollup 统计结果
+     */
+    void setRollup(int node, const Rollup &rollup);
+
+    /**
+     * @brief 从目录开始逐级向上按子节点重新合计统计
+     * @param directory 目录节点下标
+     */
+    void recomputeRollups(int directory);
+
+    /**
+     * @brief 比较节点名称
+     * @param node 节点下标
+     * @param utf8Name UTF-8编码的名称
+     * @return 名称相同返回true
+     */
+    bool nameEquals(int node, const QByteArray &utf8Name) const;
+};
+
+#endif // DIRECTORYTREEMODEL_H
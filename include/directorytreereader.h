@@ -9,10 +9,14 @@
 #define DIRECTORYTREEREADER_H
 
 #include "filefilterutil.h"
+#include "directorytreemodel.h"
+#include "directorywalker.h"
+#include "directorywatcher.h"
+#include "ignorestack.h"
+#include "progresstracker.h"
+#include "scanexporter.h"
 
 #include <QObject>
-#include <QTreeWidget>
-#include <QTreeWidgetItem>
 #include <QDir>
 #include <QFileInfo>
 #include <QFuture>
@@ -20,12 +24,19 @@
 #include <QtConcurrent>
 #include <QApplication>
 #include <QStyle>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+
+#include <atomic>
 
 /**
  * @class DirectoryTreeReader
  * @brief 目录树读取器类
  * 
- * 该类用于递归读取目录结构，并将其显示在树形控件中。
+ * 该类用于递归读取目录结构，并将结果填充到目录树模型中。
  * 使用多线程技术在后台执行目录读取操作，避免UI阻塞。
  */
 class DirectoryTreeReader : public QObject
@@ -45,10 +56,10 @@ public:
     ~DirectoryTreeReader();
     
     /**
-     * @brief 设置树形控件
-     * @param treeWidget 树形控件指针
+     * @brief 获取目录树模型
+     * @return 目录树模型指针，由读取器持有
      */
-    void setTreeWidget(QTreeWidget *treeWidget);
+    DirectoryTreeModel *model() const;
     
     /**
      * @brief 设置最大搜索深度
@@ -62,6 +73,15 @@ public:
      */
     void setReadFiles(bool readFiles);
     
+    /**
+     * @brief 设置扫描顺序
+     *
+     * 广度优先（默认）时先读取并显示所有浅层目录，再逐层读取更深的目录，
+     * 大目录的顶层结构几乎立即可用；深度优先时按子树依次完成。
+     * @param order 扫描顺序
+     */
+    void setScanOrder(DirectoryWalker::Order order);
+    
     /**
      * @brief 设置过滤规则
      * @param rules 过滤规则列表
@@ -74,65 +94,337 @@ public:
      */
     QList<FileFilterUtil::FilterRule> getFilterRules() const;
     
+    /**
+     * @brief 获取过滤规则的命中统计
+     *
+     * 只有启用了FileFilterUtil::setProfilingEnabled()时才有计数，
+     * 每次设置过滤规则后从零开始。
+     * @return 按规则列表顺序排列的统计
+     */
+    QVector<FileFilterUtil::RuleStatistics> ruleStatistics() const;
+    
     /**
      * @brief 读取目录
      * @param rootPath 根目录路径
      */
     void read(const QString &rootPath);
     
+    /**
+     * @brief 从扫描快照恢复目录树
+     *
+     * 快照存在且与当前的深度、读取文件和过滤设置一致时立即显示快照中的目录树，
+     * 然后在后台比较各目录的修改时间，只重新读取发生变化的目录。
+     *
+     * @param rootPath 根目录路径
+     * @return 快照有效并已加载时返回true
+     */
+    bool loadSnapshot(const QString &rootPath);
+    
+    /**
+     * @brief 设置是否使用扫描快照
+     * @param enabled 是否启用，启用时读取完成后写入快照，读取前优先加载快照
+     */
+    void setSnapshotEnabled(bool enabled);
+    
     /**
      * @brief 取消读取
      */
     void cancel();
     
+    /**
+     * @brief 设置是否监视目录变化
+     *
+     * 启用后，读取完成的目录会被持续监视，条目的增删只重新读取发生变化的目录，
+     * 并就地更新模型中对应的节点，无需重新读取整个目录树。
+     *
+     * @param enabled 是否启用
+     */
+    void setWatchEnabled(bool enabled);
+    
+    /**
+     * @brief 获取是否监视目录变化
+     * @return 如果已启用返回true
+     */
+    bool isWatchEnabled() const;
+    
+    /**
+     * @brief 设置是否按需读取深层目录
+     *
+     * 启用后setMaxDepth()设置的深度只决定开始时一次性读取的范围，
+     * 更深的目录在用户展开时才读取。展开的目录排在读取队列最前面，
+     * 读取完成后再预读其子目录，使视图中可见的部分总是最先读取。
+     *
+     * @param enabled 是否启用
+     */
+    void setLazyLoading(bool enabled);
+    
+    /**
+     * @brief 获取是否按需读取深层目录
+     * @return 如果已启用返回true
+     */
+    bool isLazyLoading() const;
+    
+    /**
+     * @brief 设置是否合并硬链接
+     *
+     * 经符号链接或绑定挂载重复到达的目录总是只读取一次；启用后，
+     * 同一文件的多个硬链接也只显示先读取到的那一个。
+     *
+     * @param enabled 是否启用
+     */
+    void setDeduplicateHardLinks(bool enabled);
+    
+    /**
+     * @brief 设置是否统计目录汇总信息
+     *
+     * 启用后读取目录时顺带查询文件的大小和修改时间，每个目录的子树读取完成时
+     * 自下而上合计出文件数、总大小和最新修改时间，作为模型中的附加列，
+     * 不需要再次遍历磁盘。统计结果不写入快照，启用时总是完整读取。
+     *
+     * @param enabled 是否启用
+     */
+    void setComputeRollups(bool enabled);
+    
+    /**
+     * @brief 设置是否读取各级目录中的忽略文件
+     *
+     * 启用（默认）时，读取每个目录时识别其中的.gitignore、.ignore和.aidoctoolsignore，
+     * 编译一次后压入规则栈，由所有子目录共享；被忽略的条目不显示，被忽略的目录不再打开。
+     *
+     * @param enabled 是否启用
+     */
+    void setIgnoreFilesEnabled(bool enabled);
+    
+    /**
+     * @brief 设置下一次读取时的流式导出器
+     *
+     * 读取线程每组装完一个目录就把它的条目交给导出器写出，读取结束或取消时
+     * 调用其finish()，随后自动解除，只对一次读取有效。导出需要完整读取，
+     * 不使用快照；嵌套JSON格式会使本次读取改为深度优先顺序。
+     *
+     * @param exporter 导出器，由调用方持有，读取完成前必须保持有效
+     */
+    void setExporter(ScanExporter *exporter);
+    
     /**
      * @brief 生成文本表示
+     * @param index 起始节点的模型索引，无效索引表示根节点
      * @return 目录结构的文本表示
      */
-    QString generateTextRepresentation();
+    QString generateTextRepresentation(const QModelIndex &index = QModelIndex());
+    
+    /**
+     * @brief 将文本表示直接写入设备，输出按块写入，不在内存中保留完整文本
+     * @param device 已打开的输出设备
+     * @param index 起始节点的模型索引，无效索引表示根节点
+     * @return 全部写入成功返回true
+     */
+    bool writeTextRepresentation(QIODevice *device, const QModelIndex &index = QModelIndex());
 
 signals:
     /**
-     * @brief 进度更新信号
+     * @brief 进度更新信号（约30Hz），按已读取目录数占已发现目录数的比例计算
      * @param value 进度值（0-100）
+     * @param detail 已读取目录数、读取速度和预计剩余时间
      */
-    void progressUpdated(int value);
+    void progressUpdated(int value, const QString &detail);
     
     /**
      * @brief 读取完成信号
      */
     void readingFinished();
+    
+    /**
+     * @brief 监视到的变化已更新到模型中
+     */
+    void treeUpdated();
 
 private slots:
     /**
      * @brief 读取完成槽函数
      */
     void onReadingFinished();
+    
+    /**
+     * @brief 重新读取发生变化的目录
+     * @param paths 目录路径列表
+     */
+    void refreshDirectories(const QStringList &paths);
+    
+    /**
+     * @brief 监视事件丢失后重新读取所有已读取的目录
+     */
+    void refreshAllDirectories();
+    
+    /**
+     * @brief 把当前目录树写入快照
+     */
+    void saveSnapshot();
+    
+    /**
+     * @brief 按需读取用户展开的目录
+     * @param node 目录节点下标
+     */
+    void requestListing(int node);
 
 private:
-    QTreeWidget *treeWidget;      ///< 树形控件
-    QTreeWidgetItem *rootItem;    ///< 根节点项
+    /**
+     * @brief 单个目录的重新读取结果
+     */
+    struct RefreshResult {
+        QString path;                              ///< 目录路径
+        QVector<DirectoryWalker::Entry> entries;   ///< 保留的条目
+    };
+    
+    /**
+     * @brief 子树尚未读取完成的目录的统计
+     */
+    struct PendingRollup {
+        qint32 parent = -1;         ///< 父目录节点下标
+        qint32 remaining = -1;      ///< 尚未完成的子目录数（-1表示本目录尚未读取）
+        DirectoryTreeModel::Rollup total = DirectoryTreeModel::Rollup::empty(); ///< 已完成部分的合计
+    };
+    
+    DirectoryTreeModel *treeModel; ///< 目录树模型
     int maxDepth;                 ///< 最大搜索深度
+    DirectoryWalker::Order scanOrder; ///< 扫描顺序
     bool readFiles;               ///< 是否读取文件
-    bool isCancelled;             ///< 是否已取消
+    bool deduplicateHardLinks;    ///< 是否合并硬链接
+    bool computeRollups;          ///< 是否统计目录汇总信息
+    bool ignoreFilesEnabled;      ///< 是否读取各级目录中的忽略文件
+    ScanExporter *exporter;       ///< 本次读取的流式导出器（可为空）
+    std::atomic<bool> isCancelled; ///< 是否已取消（由多个工作线程读取）
     FileFilterUtil fileFilter;    ///< 文件过滤工具
     QFutureWatcher<void> *watcher; ///< 异步任务监视器
+    int scanGeneration;           ///< 扫描批次编号，用于丢弃过期的批次
+    int nextNodeId;               ///< 下一个节点下标（仅工作线程使用）
+    quint32 nextNameOffset;       ///< 下一个名称在字符串区中的偏移（仅工作线程使用）
+    DirectoryTreeModel::NodeBatch pendingBatch; ///< 等待提交给主线程的节点（仅工作线程使用）
+    QHash<qint32, PendingRollup> pendingRollups; ///< 子树尚未完成的目录（仅工作线程使用）
+    QElapsedTimer batchTimer;     ///< 距上次提交批次的计时（仅工作线程使用）
+    DirectoryWatcher *directoryWatcher; ///< 目录变化监视器
+    bool watchEnabled;            ///< 是否监视目录变化
+    bool lazyLoading;             ///< 是否按需读取深层目录
+    bool refreshRunning;          ///< 是否有重新读取任务正在执行
+    QStringList pendingRefreshPaths; ///< 等待重新读取的目录
+    QFuture<void> refreshFuture;  ///< 正在执行的重新读取任务
+    bool snapshotEnabled;         ///< 是否使用扫描快照
+    QString currentRootPath;      ///< 当前目录树的根目录
+    int filterRootLength;         ///< 规范化的根目录路径长度，过滤时其后为相对于根目录的路径
+    IgnoreStackMap ignoreStacks;  ///< 各目录从忽略文件编译出的规则栈
+    QMutex mtimeMutex;            ///< 保护directoryMtimes
+    QHash<QString, qint64> directoryMtimes; ///< 已读取目录在读取时的修改时间
+    QTimer *snapshotTimer;        ///< 增量更新后延迟写入快照
+    QFuture<void> snapshotFuture; ///< 正在执行的快照写入任务
+    QFuture<void> revalidateFuture; ///< 正在执行的快照校验任务
+    ProgressTracker *progressTracker; ///< 扫描进度统计
     
     /**
-     * @brief 递归读取目录
+     * @brief 递归组装目录节点（在扫描任务线程中按深度优先顺序执行）
+     * @param walker 并行遍历器
+     * @param slot 目录读取结果的槽位
+     * @param nodeId 目录对应的节点下标
      * @param path 目录路径
-     * @param parent 父树项
-     * @param currentDepth 当前深度
      */
-    void readDirectory(const QString &path, QTreeWidgetItem *parent, int currentDepth);
+    void readDirectory(DirectoryWalker &walker, int slot, int nodeId, const QString &path);
     
     /**
-     * @brief 生成文本表示
-     * @param item 树项
-     * @param level 缩进级别
-     * @return 目录结构的文本表示
+     * @brief 逐层组装目录节点（在扫描任务线程中按广度优先顺序执行）
+     * @param walker 并行遍历器
+     * @param rootSlot 根目录读取结果的槽位
+     * @param rootPath 根目录路径
+     */
+    void readBreadthFirst(DirectoryWalker &walker, int rootSlot, const QString &rootPath);
+    
+    /**
+     * @brief 按组装顺序取出一个目录的读取结果，处理重复目录并统计进度
+     * @param walker 并行遍历器
+     * @param slot 目录读取结果的槽位
+     * @param path 目录路径
+     * @return 目录条目
+     */
+    QVector<DirectoryWalker::Entry> takeListing(DirectoryWalker &walker, int slot, const QString &path);
+    
+    /**
+     * @brief 将一个目录的条目追加为连续的子节点，并记录该目录的子节点范围
+     * @param nodeId 目录对应的节点下标
+     * @param entries 目录条目
+     * @return 第一个子节点的下标
+     */
+    int appendListing(int nodeId, const QVector<DirectoryWalker::Entry> &entries);
+    
+    /**
+     * @brief 目录的子树已全部读取，提交其统计并合计到父目录，必要时逐级向上完成
+     * @param nodeId 目录对应的节点下标
+     */
+    void completeRollup(int nodeId);
+    
+    /**
+     * @brief 读取并过滤单个目录（在遍历器的工作线程中并发执行）
+     *
+     * 保留的子目录的上下文记录本目录的子树决策，子目录读取时直接继承。
+     * @param path 目录路径
+     * @param inherited 父目录的子树决策，未知时为TestEntries
+     * @param result 保留的条目
+     * @param directoryId 非空时输出目录自身的标识，供遍历器判定重复到达的目录
+     */
+    void listDirectory(const QString &path, FileFilterUtil::DirectoryVerdict inherited,
+                       QVector<DirectoryWalker::Entry> &result, DirectoryScanner::FileId *directoryId = nullptr);
+    
+    /**
+     * @brief 将已完成的节点批量提交给主线程
+     * @param force 为true时即使批次未满也立即提交
+     */
+    void flushPendingNodes(bool force = false);
+    
+    /**
+     * @brief 计算区分扫描参数的快照键
+     * @param rootPath 根目录路径
+     * @return 快照键
+     */
+    QByteArray snapshotKey(const QString &rootPath) const;
+    
+    /**
+     * @brief 在后台比较目录修改时间，重新读取发生变化的目录
+     * @param paths 目录路径
+     * @param mtimes 快照中记录的修改时间
+     */
+    void revalidate(const QStringList &paths, const QVector<qint64> &mtimes);
+    
+    /**
+     * @brief 监视当前目录树中所有已读取的目录
+     */
+    void startWatching();
+    
+    /**
+     * @brief 获取当前目录树中所有已读取的目录
+     * @return 目录路径列表
+     */
+    QStringList listedDirectories() const;
+    
+    /**
+     * @brief 在后台重新读取等待中的目录
+     */
+    void startNextRefresh();
+    
+    /**
+     * @brief 将重新读取的结果应用到模型（在主线程执行）
+     * @param generation 发起任务时的扫描批次编号
+     * @param results 重新读取的结果
+     */
+    void applyRefresh(int generation, const QVector<RefreshResult> &results);
+    
+    /**
+     * @brief 按深度优先顺序一次遍历生成UTF-8文本表示
+     *
+     * 每个祖先是否为最后一个子项记录在栈中，据此增量维护行前缀，
+     * 每个节点只访问一次。
+     * @param node 起始节点下标
+     * @param buffer 输出缓冲区
+     * @param device 输出设备，非空时缓冲区积累到一定大小就写入设备并清空
+     * @return 写入设备失败时返回false
      */
-    QString generateTextRepresentation(QTreeWidgetItem *item, int level = 0);
+    bool renderText(int node, QByteArray &buffer, QIODevice *device) const;
 };
 
 #endif // DIRECTORYTREEREADER_H 
\ No newline at end of file
@@ -0,0 +1,254 @@
+/**
+ * @file directorywalker.h
+ * @brief 并行目录遍历器类的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+#include "directoryscanner.h"
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QSet>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @class DirectoryWalker
+ * @brief 基于工作窃取的并行目录遍历器
+ *
+ * 每个目录是一个工作项。每个工作线程拥有自己的双端队列：
+ * 从队尾取出自己产生的子目录（深度优先，局部性好），
+ * 空闲时从其他线程的队首窃取（通常是较大的子树）。
+ *
+ * 广度优先模式下不再区分自己和其他线程的队列，总是取出深度最小的目录，
+ * 浅层目录全部读取完之后才开始读取更深的目录。
+ *
+ * 工作线程读取的结果存放在按编号分配的槽位中，调用方通过take()
+ * 按自己需要的顺序取出，因此无论线程如何调度，呈现顺序都是确定的。
+ *
+ * 符号链接和绑定挂载会让同一目录出现在多条路径上。工作线程只报告目录和文件的标识，
+ * 是否重复由take()按取出顺序判定，总是先取出的路径保留，结果同样与调度无关。
+ */
+class DirectoryWalker
+{
+public:
+    /**
+     * @brief 目录条目
+     */
+    struct Entry {
+        QString name;   ///< 名称
+        bool isDir;     ///< 是否为目录
+        int slot;       ///< 子目录读取结果的槽位（-1表示不继续读取）
+        qint64 size;    ///< 文件大小（字节），未查询时为0
+        qint64 modified; ///< 文件修改时间（自纪元起的毫秒数），未查询时为0
+        quint8 context; ///< 读取函数为子目录记录的上下文，读取该子目录时原样传回
+        DirectoryScanner::FileId id; ///< 文件标识，用于合并硬链接，无效时不参与合并
+
+        Entry() : isDir(false), slot(-1), size(0), modified(0), context(0) {}
+        Entry(const QString &n, bool dir) : name(n), isDir(dir), slot(-1), size(0), modified(0), context(0) {}
+    };
+
+    /**
+     * @brief 遍历顺序
+     */
+    enum class Order {
+        DepthFirst,     ///< 深度优先（默认，局部性好）
+        BreadthFirst    ///< 广度优先（浅层目录优先读取）
+    };
+
+    /**
+     * @brief 读取单个目录的函数
+     *
+     * 在工作线程中并发调用，需要是线程安全的。应按最终呈现顺序填充条目，
+     * 并且只返回需要保留的条目（过滤在这里完成）。
+     * 参数依次为目录路径、目录深度、父目录为它记录的上下文（根目录为0）、输出的条目列表
+     * 和输出的目录自身标识（无法取得时保持无效，该目录不参与重复判定）。
+     */
+    using ListFunction = std::function<void(const QString &, int, quint8, QVector<Entry> &,
+                                            DirectoryScanner::FileId &)>;
+
+    /**
+     * @brief 取消检查函数，返回true表示调用方已取消
+     */
+    using CancelFunction = std::function<bool()>;
+
+    /**
+     * @brief 构造函数
+     * @param listFunction 读取单个目录的函数
+     * @param cancelFunction 取消检查函数
+     * @param threadCount 工作线程数量，0表示使用理想线程数
+     */
+    DirectoryWalker(ListFunction listFunction, CancelFunction cancelFunction, int threadCount = 0);
+
+    /**
+     * @brief 析构函数，取消剩余工作并等待工作线程退出
+     */
+    ~DirectoryWalker();
+
+    /**
+     * @brief 设置最大深度
+     * @param depth 深度超过该值的子目录不会被读取
+     */
+    void setMaxDepth(int depth);
+
+    /**
+     * @brief 设置遍历顺序（需在start()之前调用）
+     * @param order 遍历顺序
+     */
+    void setOrder(Order order);
+
+    /**
+     * @brief 设置是否合并硬链接（需在start()之前调用）
+     * @param enabled 为true时同一文件只在第一次取出时保留
+     */
+    void setDeduplicateFiles(bool enabled);
+
+    /**
+     * @brief 开始遍历
+     * @param rootPath 根目录路径
+     * @param rootDepth 根目录的深度
+     * @return 根目录读取结果的槽位
+     */
+    int start(const QString &rootPath, int rootDepth);
+
+    /**
+     * @brief 取出某个目录的读取结果，必要时等待其完成
+     *
+     * 只能在一个线程中调用。已经从其他路径取出过的目录按空目录返回，其子目录不再读取。
+     * @param slot 槽位
+     * @param duplicate 非空时输出该目录是否已经从其他路径取出过
+     * @return 目录条目，遍历被取消时返回空列表
+     */
+    QVector<Entry> take(int slot, bool *duplicate = nullptr);
+
+    /**
+     * @brief 取消遍历（线程安全）
+     */
+    void cancel();
+
+    /**
+     * @brief 拼接子路径
+     * @param dirPath 目录路径
+     * @param name 条目名称
+     * @return 子路径
+     */
+    static QString childPath(const QString &dirPath, const QString &name);
+
+private:
+    /**
+     * @brief 工作项（一个待读取的目录）
+     */
+    struct WorkItem {
+        QString path;   ///< 目录路径
+        int depth;      ///< 目录深度
+        int slot;       ///< 结果槽位
+        quint8 context; ///< 父目录为它记录的上下文
+    };
+
+    /**
+     * @brief 单个工作线程的任务队列
+     */
+    struct WorkerQueue {
+        QMutex mutex;                   ///< 保护items
+        std::deque<WorkItem> items;     ///< 待处理的目录
+    };
+
+    /**
+     * @brief 结果槽位
+     */
+    struct Slot {
+        QVector<Entry> entries;         ///< 读取结果
+        DirectoryScanner::FileId id;    ///< 目录自身的标识
+        int parent = -1;                ///< 父目录的槽位（根目录为-1）
+        bool ready = false;             ///< 是否已完成读取
+        bool discarded = false;         ///< 是否位于重复目录之下，不再读取
+    };
+
+    ListFunction listFunction;      ///< 读取单个目录的函数
+    CancelFunction cancelFunction;  ///< 取消检查函数
+    int threadCount;                ///< 工作线程数量
+    int maxDepth;                   ///< 最大深度
+    Order order;                    ///< 遍历顺序
+    bool deduplicateFiles;          ///< 是否合并硬链接
+    QThreadPool threadPool;         ///< 工作线程池
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues; ///< 每个线程的任务队列
+    QAtomicInt queuedItems;         ///< 队列中尚未取出的工作项数量
+    QAtomicInt pendingItems;        ///< 尚未处理完成的工作项数量（含正在处理的）
+    QAtomicInt cancelled;           ///< 是否已取消
+    QMutex idleMutex;               ///< 空闲等待用互斥锁
+    QWaitCondition workAvailable;   ///< 有新工作或遍历结束
+
+    QMutex slotMutex;               ///< 保护slots
+    QWaitCondition slotReady;       ///< 有槽位完成
+    std::deque<Slot> slots;         ///< 结果槽位（deque保证扩容时已有元素地址不变）
+    QSet<DirectoryScanner::FileId> takenIds; ///< 已取出的目录和文件的标识（只在take()中访问）
+
+    /**
+     * @brief 工作线程主循环
+     * @param index 工作线程序号
+     */
+    void workerLoop(int index);
+
+    /**
+     * @brief 取出一个工作项：先从自己的队尾取，再从其他线程的队首窃取
+     * @param index 工作线程序号
+     * @param item 输出的工作项
+     * @return 是否取到
+     */
+    bool acquireWork(int index, WorkItem &item);
+
+    /**
+     * @brief 广度优先模式下取出深度最小的工作项
+     * @param item 输出的工作项
+     * @return 是否取到
+     */
+    bool acquireShallowest(WorkItem &item);
+
+    /**
+     * @brief 读取一个目录并派发其子目录
+     * @param index 工作线程序号
+     * @param item 工作项
+     */
+    void process(int index, const WorkItem &item);
+
+    /**
+     * @brief 将工作项压入指定线程的队尾
+     * @param index 工作线程序号
+     * @param items 工作项（按顺序压入）
+     */
+    void push(int index, std::vector<WorkItem> &items);
+
+    /**
+     * @brief 判断标识是否与某个祖先目录相同（调用时需持有slotMutex）
+     * @param slot 目录的槽位
+     * @param id 目录自身的标识
+     * @return 是否形成环
+     */
+    bool isAncestor(int slot, const DirectoryScanner::FileId &id) const;
+
+    /**
+     * @brief 丢弃槽位及其下已分配的所有子目录槽位（调用时需持有slotMutex）
+     * @param slot 槽位
+     */
+    void discard(int slot);
+
+    /**
+     * @brief 检查是否已取消，同时同步调用方的取消状态
+     * @return 是否已取消
+     */
+    bool isCancelled();
+};
+
+#endif // DIRECTORYWALKER_H
@@ -0,0 +1,127 @@
+/**
+ * @file directorywatcher.h
+ * @brief 目录变化监视器的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef DIRECTORYWATCHER_H
+#define DIRECTORYWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QElapsedTimer>
+
+class QSocketNotifier;
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @class DirectoryWatcher
+ * @brief 目录变化监视器
+ *
+ * 在Linux上直接使用inotify，只订阅条目的创建、删除和移动事件，以及文件写入完成事件；
+ * 写入完成只对忽略文件（见IgnoreStack::fileNames()）生效，其他文件内容的修改不会引起通知。
+ * 忽略文件的变化影响整个子树的过滤结果，该目录和其下所有已监视的目录都会被通知。
+ * 空闲时没有任何轮询。inotify不可用时回退到QFileSystemWatcher，它只报告目录条目的变化，
+ * 就地修改忽略文件的内容不会被发现。
+ *
+ * 短时间内的大量事件（例如git checkout）会被合并：最后一个事件之后
+ * 安静一段时间才发出一次directoriesChanged()，持续不断的事件流也会
+ * 在最长合并时间后强制发出，每个目录在一次通知中只出现一次。
+ */
+class DirectoryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit DirectoryWatcher(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数
+     */
+    ~DirectoryWatcher();
+
+    /**
+     * @brief 监视目录（不递归）
+     * @param path 目录路径
+     * @return 是否成功添加（达到系统监视数量上限时返回false）
+     */
+    bool addPath(const QString &path);
+
+    /**
+     * @brief 取消监视目录及其所有已监视的子目录
+     * @param path 目录路径
+     */
+    void removePath(const QString &path);
+
+    /**
+     * @brief 取消所有监视并丢弃尚未发出的变化
+     */
+    void clear();
+
+    /**
+     * @brief 获取当前监视的目录数量
+     * @return 目录数量
+     */
+    int watchCount() const;
+
+signals:
+    /**
+     * @brief 目录内容发生变化（已合并）
+     * @param paths 条目发生增删或移动的目录
+     */
+    void directoriesChanged(const QStringList &paths);
+
+    /**
+     * @brief 内核事件队列溢出，部分变化已丢失，需要重新检查所有目录
+     */
+    void rescanRequired();
+
+private slots:
+    /**
+     * @brief 读取inotify事件
+     */
+    void readInotifyEvents();
+
+    /**
+     * @brief 发出合并后的变化
+     */
+    void flushChanges();
+
+private:
+    int inotifyFd;                          ///< inotify文件描述符，不可用时为-1
+    QSocketNotifier *notifier;              ///< inotify可读通知
+    QFileSystemWatcher *fallbackWatcher;    ///< inotify不可用时的回退监视器
+    QHash<int, QString> watchPaths;         ///< 监视描述符到目录路径
+    QHash<QString, int> pathWatches;        ///< 目录路径到监视描述符
+    QSet<QString> dirtyPaths;               ///< 等待发出的变化目录
+    QTimer *coalesceTimer;                  ///< 合并计时器
+    QElapsedTimer firstChangeTimer;         ///< 距本轮第一个变化的时间
+
+    /**
+     * @brief 记录一个发生变化的目录并推迟发出通知
+     * @param path 目录路径
+     */
+    void markDirty(const QString &path);
+
+    /**
+     * @brief 记录目录及其下所有已监视的目录发生了变化
+     * @param path 目录路径
+     */
+    void markSubtreeDirty(const QString &path);
+
+    /**
+     * @brief 取消单个目录的监视
+     * @param path 目录路径
+     */
+    void removeWatch(const QString &path);
+};
+
+#endif // DIRECTORYWATCHER_H
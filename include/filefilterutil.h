@@ -12,7 +12,10 @@
 #include <QStringList>
 #include <QRegularExpression>
 #include <QMap>
-#include <filesystem>
+#include <QSharedPointer>
+#include <QVector>
+
+class FilterMatcher;
 
 /**
  * @class FileFilterUtil
@@ -20,6 +23,9 @@
  * 
  * 该类提供了文件过滤相关的功能，包括通配符和正则表达式匹配，
  * 以及基于规则的过滤和包含功能。
+ *
+ * 规则列表每次变化时都重新编译为一个不可变的FilterMatcher，
+ * 逐条目检查时只使用编译结果，不再分析规则或构造正则表达式。
  */
 class FileFilterUtil
 {
@@ -37,7 +43,25 @@ public:
      */
     enum class MatchType {
         Wildcard,   ///< 通配符匹配
-        Regex       ///< 正则表达式匹配
+        Regex,      ///< 正则表达式匹配
+        Gitignore   ///< gitignore语法，相对于扫描根目录匹配，排除的目录不再读取
+    };
+
+    /**
+     * @brief 条目类型，由扫描器根据目录项给出
+     */
+    enum class EntryKind {
+        File,       ///< 文件（包括符号链接等非目录条目）
+        Directory   ///< 目录
+    };
+
+    /**
+     * @brief 目录整个子树的过滤决策，由父目录传给子目录
+     */
+    enum class DirectoryVerdict : quint8 {
+        TestEntries,    ///< 需要逐个检查条目
+        IncludeAll,     ///< 子树中的条目全部包含（build目录除外）
+        ExcludeAll      ///< 子树中的条目全部排除
     };
 
     /**
@@ -54,6 +78,19 @@ public:
             : pattern(p), matchType(mt), filterMode(fm), enabled(en) {}
     };
 
+    /**
+     * @brief 单条规则的命中统计
+     *
+     * 命中表示这条规则决定了条目的结果；未命中表示检查过这条规则但结果由其他规则决定或没有规则匹配。
+     * 放入哈希索引或自动机的规则与同类规则一起查找，只能按规则数平分查找用时；
+     * 正则表达式逐条匹配，用时单独统计。整个子树被包含或排除时，其中的条目不计入统计。
+     */
+    struct RuleStatistics {
+        quint64 hits = 0;           ///< 命中次数
+        quint64 misses = 0;         ///< 未命中次数
+        quint64 nanoseconds = 0;    ///< 累计用时（纳秒）
+    };
+
     /**
      * @brief 构造函数
      */
@@ -107,47 +144,96 @@ public:
     void clearFilterRules();
 
     /**
-     * @brief 检查文件是否应该被包含
-     * @param fileName 文件名
-     * @param filePath 文件路径
-     * @return 如果文件应该被包含则返回true，否则返回false
+     * @brief 检查条目是否应该被包含
+     *
+     * 只根据规则和传入的路径、类型判断，不访问文件系统。
+     * 目录被排除时整个子树都被排除，调用方不应再读取它。
+     * @param normalizedPath 规范化的路径（见normalizePath()和childPath()）
+     * @param kind 条目类型
+     * @param relativeStart 路径中相对于扫描根目录的部分的起始下标（即规范化的根目录路径长度）
+     * @return 如果条目应该被包含则返回true，否则返回false
      */
-    bool shouldIncludeFile(const QString &fileName, const QString &filePath = QString()) const;
+    bool shouldInclude(const QString &normalizedPath, EntryKind kind, int relativeStart = 0) const;
 
     /**
-     * @brief 检查文件是否应该被排除
-     * @param fileName 文件名
-     * @param filePath 文件路径
-     * @return 如果文件应该被排除则返回true，否则返回false
+     * @brief 检查条目是否应该被排除
+     * @param normalizedPath 规范化的路径
+     * @param kind 条目类型
+     * @param relativeStart 路径中相对于扫描根目录的部分的起始下标
+     * @return 如果条目应该被排除则返回true，否则返回false
      */
-    bool shouldExcludeFile(const QString &fileName, const QString &filePath = QString()) const;
-
-private:
-    QList<FilterRule> m_filterRules;   ///< 过滤规则列表
+    bool shouldExclude(const QString &normalizedPath, EntryKind kind, int relativeStart = 0) const;
 
     /**
-     * @brief 检查文件是否匹配指定规则
-     * @param fileName 文件名
-     * @param filePath 文件路径
-     * @param rule 过滤规则
-     * @return 如果文件匹配规则则返回true，否则返回false
+     * @brief 规范化路径：清理多余的分隔符和./、../，统一使用正斜杠，目录以/结尾
+     *
+     * 只做字符串处理，不访问文件系统。
+     * @param path 输入路径
+     * @param kind 条目类型
+     * @return 规范化后的路径
      */
-    bool matchesRule(const QString &fileName, const QString &filePath, const FilterRule &rule) const;
-    
+    static QString normalizePath(const QString &path, EntryKind kind);
+
     /**
-     * @brief 规范化路径
-     * @param path 输入路径
+     * @brief 拼接子条目的规范化路径
+     * @param normalizedDirectory 规范化的目录路径（以/结尾）
+     * @param name 条目名
+     * @param kind 条目类型
      * @return 规范化后的路径
      */
-    QString normalizePath(const QString &path) const;
-    
+    static QString childPath(const QString &normalizedDirectory, const QString &name, EntryKind kind);
+
+    /**
+     * @brief 在路径缓冲区中把子条目名替换为另一个
+     *
+     * 缓冲区先截回到目录部分再拼接条目名。逐条目过滤时反复使用同一个缓冲区，
+     * 只要它没有被共享且容量足够（如预留了目录长度加最长文件名），就不会分配内存。
+     * @param path 路径缓冲区，前directoryLength个字符为以/结尾的规范化目录路径
+     * @param directoryLength 目录部分的长度
+     * @param name 条目名
+     * @param kind 条目类型
+     */
+    static void replaceChildName(QString &path, qsizetype directoryLength, const QString &name, EntryKind kind);
+
+    /**
+     * @brief 获取当前规则列表编译出的匹配器
+     *
+     * 匹配器不可变，读取线程可以在整个读取过程中持有同一个匹配器。
+     * @return 匹配器，不会为空
+     */
+    QSharedPointer<const FilterMatcher> matcher() const;
+
+    /**
+     * @brief 启用或禁用规则命中统计
+     *
+     * 对所有匹配器生效。禁用时每个条目只多一次原子读取；
+     * 启用后每次查找都要计时，扫描会明显变慢，只在分析规则时打开。
+     * @param enabled 是否启用
+     */
+    static void setProfilingEnabled(bool enabled);
+
+    /**
+     * @brief 判断规则命中统计是否启用
+     * @return 启用时返回true
+     */
+    static bool isProfilingEnabled();
+
+    /**
+     * @brief 获取当前匹配器的规则命中统计
+     *
+     * 统计随匹配器一起创建，规则列表变化后从零开始。
+     * @return 按规则列表顺序排列的统计，禁用的规则全部为0
+     */
+    QVector<RuleStatistics> ruleStatistics() const;
+
+private:
+    QList<FilterRule> m_filterRules;   ///< 过滤规则列表
+    QSharedPointer<const FilterMatcher> m_matcher; ///< 由m_filterRules编译出的匹配器
+
     /**
-     * @brief 检查路径是否是另一个路径的子路径
-     * @param path 要检查的路径
-     * @param basePath 基础路径
-     * @return 如果是子路径则返回true
+     * @brief 重新编译规则列表
      */
-    bool isSubPath(const QString &path, const QString &basePath) const;
+    void compileRules();
 };
 
-#endif // FILEFILTERUTIL_H 
\ No newline at end of file
+#endif // FILEFILTERUTIL_H
\ No newline at end of file
@@ -8,6 +8,13 @@
 #ifndef FILEMERGER_H
 #define FILEMERGER_H
 
+#include "directorywalker.h"
+#include "directoryscanner.h"
+#include "ignorerules.h"
+#include "ignorestack.h"
+#include "progresstracker.h"
+#include "scanresult.h"
+
 #include <QObject>
 #include <QStringList>
 #include <QRegularExpression>
@@ -15,6 +22,8 @@
 #include <QFuture>
 #include <QFutureWatcher>
 
+#include <atomic>
+
 /**
  * @class FileMerger
  * @brief 用于搜索和合并文本文件的类
@@ -59,6 +68,9 @@ public:
     
     /**
      * @brief 设置文件包含规则
+     *
+     * 规则按gitignore语法解释，相对于根目录匹配；匹配某条规则
+     * （或位于匹配的目录中）且没有被之后的!规则取消的文件将被包含。
      * @param rules 包含规则列表，匹配这些规则的文件将被包含
      */
     void setFilterRules(const QStringList &rules);
@@ -83,6 +95,26 @@ public:
      */
     void setExtractionRule(const QString &regex, bool enabled);
     
+    /**
+     * @brief 设置是否合并硬链接
+     *
+     * 经符号链接或绑定挂载重复到达的目录总是只搜索一次；启用后，
+     * 同一文件的多个硬链接也只合并先找到的那一个。
+     *
+     * @param enabled 是否启用
+     */
+    void setDeduplicateHardLinks(bool enabled);
+    
+    /**
+     * @brief 设置是否读取各级目录中的忽略文件
+     *
+     * 启用（默认）时，搜索每个目录时识别其中的.gitignore、.ignore和.aidoctoolsignore，
+     * 编译一次后由所有子目录共享；被忽略的文件不合并，被忽略的目录不再搜索。
+     *
+     * @param enabled 是否启用
+     */
+    void setIgnoreFilesEnabled(bool enabled);
+    
     /**
      * @brief 开始搜索和合并文件
      */
@@ -114,10 +146,11 @@ public:
 
 signals:
     /**
-     * @brief 进度更新信号
+     * @brief 进度更新信号（约30Hz），按已读取字节数占预计总字节数的比例计算
      * @param value 进度值（0-100）
+     * @param detail 已读取字节数、读取速度和预计剩余时间
      */
-    void progressUpdated(int value);
+    void progressUpdated(int value, const QString &detail);
     
     /**
      * @brief 处理完成信号
@@ -137,22 +170,49 @@ private:
     QString fileFilter;              ///< 文件过滤模式
     bool useRegex;                   ///< 是否使用正则表达式过滤
     QStringList filterRules;         ///< 文件包含规则列表
+    QRegularExpression fileFilterExpression;        ///< 由fileFilter编译出的表达式
+    IgnoreRules ruleSet;             ///< 由filterRules按gitignore语法编译出的规则集
     QString headerTemplate;          ///< 文件头模板
     bool useSeparator;               ///< 是否使用分隔符
     QString separator;               ///< 文件间分隔符
     QString extractionRegex;         ///< 内容提取正则表达式
     bool useExtraction;              ///< 是否使用内容提取
+    bool deduplicateHardLinks;       ///< 是否合并硬链接
+    bool ignoreFilesEnabled;         ///< 是否读取各级目录中的忽略文件
+    IgnoreStackMap ignoreStacks;     ///< 各目录从忽略文件编译出的规则栈
     QFutureWatcher<void> *watcher;   ///< 用于异步处理的Future监视器
-    bool isCancelled;                ///< 是否已取消操作
+    std::atomic<bool> isCancelled;   ///< 是否已取消操作（由多个工作线程读取）
     QString mergedText;              ///< 合并后的文本
-    QStringList foundFiles;          ///< 找到的文件列表
+    ScanResult foundTree;            ///< 搜索到的目录和文件（名称只存一次，路径按需拼接）
+    QVector<qint32> foundFiles;      ///< 找到的文件在foundTree中的节点下标，按合并顺序排列
+    QVector<DirectoryScanner::Metadata> fileMetadata; ///< 与foundFiles对应的预取元数据
+    ProgressTracker *progressTracker; ///< 合并进度统计
 
     /**
-     * @brief 递归搜索文件
-     * @param path 当前目录路径
+     * @brief 递归收集文件（在合并任务线程中按深度优先顺序执行）
+     * @param walker 并行遍历器
+     * @param slot 目录读取结果的槽位
+     * @param node 当前目录在foundTree中的节点下标
+     */
+    void searchFiles(DirectoryWalker &walker, int slot, int node);
+    
+    /**
+     * @brief 拼接一段已找到文件的完整路径
+     * @param from 起始序号
+     * @param count 数量
+     * @return 文件路径
+     */
+    QStringList foundFilePaths(int from, int count) const;
+    
+    /**
+     * @brief 读取并过滤单个目录（在遍历器的工作线程中并发执行）
+     * @param path 目录路径
      * @param currentDepth 当前深度
+     * @param result 子目录和匹配的文件
+     * @param directoryId 输出目录自身的标识，供遍历器判定重复到达的目录
      */
-    void searchFiles(const QString &path, int currentDepth);
+    void listDirectory(const QString &path, int currentDepth, QVector<DirectoryWalker::Entry> &result,
+                       DirectoryScanner::FileId &directoryId);
     
     /**
      * @brief 合并文件内容
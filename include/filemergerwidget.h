@@ -90,8 +90,9 @@ private slots:
     /**
      * @brief 处理进度更新事件
      * @param value 进度值
+     * @param detail 进度说明
      */
-    void onProgressUpdated(int value);
+    void updateProgress(int value, const QString &detail);
     
     /**
      * @brief 处理文件处理事件
@@ -0,0 +1,66 @@
+/**
+ * @file filemetadatacollector.h
+ * @brief 批量文件元数据收集器的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef FILEMETADATACOLLECTOR_H
+#define FILEMETADATACOLLECTOR_H
+
+#include "directoryscanner.h"
+
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class FileMetadataCollector
+ * @brief 批量文件元数据收集器
+ *
+ * 需要大量文件的大小、修改时间（例如文件头中的{size}、{date}、{time}占位符）
+ * 或需要连续打开大量文件时，逐个发起阻塞的系统调用会被单次延迟拖慢，
+ * 在冷缓存和FUSE挂载上尤其明显。
+ *
+ * 在支持io_uring的Linux内核上，该类把statx和openat以大批次提交到io_uring；
+ * 运行时检测到io_uring不可用（旧内核、被禁用或非Linux平台）时，
+ * 回退为在线程池中并行调用DirectoryScanner::queryMetadata()；
+ * io_uring中途出错时先等待已提交的请求完成，再以同样方式处理剩下的文件。
+ */
+class FileMetadataCollector
+{
+public:
+    /**
+     * @brief 检测当前系统是否可以使用io_uring（结果在首次调用后缓存）
+     * @return 支持statx和openat操作时返回true
+     */
+    static bool isUringAvailable();
+
+    /**
+     * @brief 批量查询文件元数据
+     * @param paths 文件路径列表
+     * @param metadata 输出的元数据，与paths一一对应
+     * @return 每个文件是否查询成功，与paths一一对应
+     */
+    static QVector<bool> collect(const QStringList &paths, QVector<DirectoryScanner::Metadata> &metadata);
+
+    /**
+     * @brief 批量以只读方式打开文件
+     *
+     * 仅在io_uring可用时执行批量打开；否则返回全部为-1的列表，
+     * 调用方应按常规方式逐个打开；io_uring中途出错时，尚未打开的文件同样为-1。
+     * 返回的文件描述符由调用方负责关闭。
+     *
+     * @param paths 文件路径列表
+     * @return 文件描述符列表，与paths一一对应，失败为-1
+     */
+    static QVector<int> openFiles(const QStringList &paths);
+
+    /**
+     * @brief 关闭openFiles()返回但未被使用的文件描述符
+     * @param fds 文件描述符列表
+     * @param from 从该位置开始关闭，之前的描述符视为已被调用方接管
+     */
+    static void closeFiles(const QVector<int> &fds, int from = 0);
+};
+
+#endif // FILEMETADATACOLLECTOR_H
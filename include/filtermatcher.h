@@ -0,0 +1,225 @@
+/**
+ * @file filtermatcher.h
+ * @brief 编译后的过滤规则匹配器的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef FILTERMATCHER_H
+#define FILTERMATCHER_H
+
+#include "filefilterutil.h"
+#include "ignorerules.h"
+#include "literalset.h"
+#include "substringautomaton.h"
+
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class FilterMatcher
+ * @brief 由过滤规则列表编译出的不可变匹配器
+ *
+ * 规则在构造时一次性分析：通配符按形式归类为前缀、后缀、包含或精确比较，
+ * 只有复杂通配符和正则表达式才生成QRegularExpression，并在构造时完成编译优化；
+ * 路径类规则的分隔符统一为'/'，匹配时用到的"/名称/"等字符串也预先拼好。
+ *
+ * 同一模式（包含或排除）的规则不再逐条检查：精确路径、前缀和后缀（如*.cpp的扩展名）
+ * 分别放入哈希集合，包含类规则和"/名称/"等目录子串合并为一个Aho-Corasick自动机，
+ * 只有正则表达式逐条匹配。路径只折叠一次大小写，之后每类只查一次，
+ * 几百条简单规则的代价与几条相当。
+ *
+ * gitignore类型的规则按顺序编译为一个IgnoreRules，相对于扫描根目录匹配；
+ * 被它忽略的目录连同整个子树一起排除，扫描器不会再打开它。
+ *
+ * 目录的决策还包括读取器的两条默认策略：没有包含规则提到build时自动排除build目录；
+ * 存在文件类型包含规则（如*.cpp）时，没有被明确排除的目录仍然保留以便遍历。
+ *
+ * 目录还可以得到整个子树的决策：路径中已经出现了某条包含规则的子串或前缀时，
+ * 其下所有路径都会匹配这条规则；排除规则同理。这样的决策由子目录继承，
+ * 子树中的条目不再逐个检查规则。
+ *
+ * 匹配只依赖传入的路径和条目类型，不访问文件系统。
+ * 构造完成后不再修改，可以在多个读取线程之间共享。
+ * 启用规则命中统计（FileFilterUtil::setProfilingEnabled）时，
+ * 匹配过程只更新原子计数器，匹配结果不受影响。
+ */
+class FilterMatcher
+{
+public:
+    /**
+     * @brief 构造函数，编译规则列表
+     * @param rules 过滤规则列表（包括禁用的规则）
+     */
+    explicit FilterMatcher(const QList<FileFilterUtil::FilterRule> &rules);
+
+    /**
+     * @brief 检查条目是否应该被包含
+     *
+     * 目录返回false时整个子树都被排除，调用方不应再读取它。
+     * @param path 规范化的路径，分隔符为'/'，目录以'/'结尾
+     * @param relativeStart 路径中相对于扫描根目录的部分的起始下标，gitignore规则据此锚定
+     * @param kind 条目类型
+     * @param verdict 条目所在目录的子树决策，为IncludeAll或ExcludeAll时不再检查规则
+     * @return 应该被包含时返回true
+     */
+    bool shouldInclude(const QString &path, int relativeStart, FileFilterUtil::EntryKind kind,
+                       FileFilterUtil::DirectoryVerdict verdict = FileFilterUtil::DirectoryVerdict::TestEntries) const;
+
+    /**
+     * @brief 计算目录整个子树的决策
+     *
+     * 父目录的决策不是TestEntries时直接继承，否则只根据目录本身的路径判断一次。
+     * @param path 规范化的目录路径，以'/'结尾
+     * @param inherited 父目录的子树决策，未知时为TestEntries
+     * @return 子树决策
+     */
+    FileFilterUtil::DirectoryVerdict directoryVerdict(const QString &path,
+                                                      FileFilterUtil::DirectoryVerdict inherited) const;
+
+    /**
+     * @brief 获取规则命中统计
+     *
+     * 读取线程可能仍在更新计数，结果是某一时刻的近似值。
+     * @return 按规则列表顺序排列的统计
+     */
+    QVector<FileFilterUtil::RuleStatistics> statistics() const;
+
+private:
+    /**
+     * @brief 规则的匹配方式
+     */
+    enum class Kind {
+        All,        ///< 通配符*，匹配所有内容
+        Contains,   ///< *xxx*，包含字面量
+        Suffix,     ///< *xxx，以字面量结尾
+        Prefix,     ///< xxx*，以字面量开头
+        Exact,      ///< 不含通配符，与字面量完全相同
+        Expression  ///< 复杂通配符或正则表达式
+    };
+
+    /**
+     * @brief 编译后的单条规则
+     */
+    struct CompiledRule {
+        int index;                      ///< 规则在规则列表中的下标
+        Kind kind;                      ///< 匹配方式
+        QString literal;                ///< 前缀、后缀、包含或精确比较的字面量
+        QRegularExpression expression;  ///< 已编译优化的正则表达式
+        QString directoryName;          ///< 分隔符统一为'/'并去掉末尾'/'的模式
+        QString directoryNeedle;        ///< "/" + directoryName + "/"
+        QString directorySuffix;        ///< "/" + directoryName
+        bool directoryRule;             ///< 是否为目录规则（以'/'结尾或为build）
+        bool trailingSeparator;         ///< 模式是否以分隔符结尾
+        bool pathRule;                  ///< 模式是否包含分隔符
+        bool relativePath;              ///< 路径模式是否以/、./或../开头
+        bool includesDirectories;       ///< 包含规则是否默认包含所有目录
+    };
+
+    /**
+     * @brief 一组一起查找的规则的统计计数
+     */
+    struct GroupCounter {
+        mutable std::atomic<quint64> lookups{0};        ///< 查找次数
+        mutable std::atomic<quint64> nanoseconds{0};    ///< 查找的累计用时
+        int ruleCount = 0;                              ///< 参与查找的规则数
+    };
+
+    /**
+     * @brief 单条规则的统计计数
+     */
+    struct RuleCounter {
+        const GroupCounter *group = nullptr;    ///< 规则所在的索引组，为空表示规则未启用
+        bool indexed = false;                   ///< 是否放入了索引
+        std::atomic<quint64> hits{0};           ///< 命中次数
+        std::atomic<quint64> evaluations{0};    ///< 单独匹配正则表达式的次数
+        std::atomic<quint64> nanoseconds{0};    ///< 单独匹配正则表达式的累计用时
+    };
+
+    /**
+     * @brief 同一模式的规则按匹配方式分类后的索引，值均为规则下标
+     */
+    struct RuleSet {
+        bool isEmpty = true;                ///< 是否没有任何规则
+        int allRule = -1;                   ///< 匹配所有条目的规则
+        int directoryRule = -1;             ///< 默认包含所有目录的规则
+        LiteralSet exactPaths;              ///< 与完整路径相同的字面量
+        LiteralSet prefixes;                ///< 路径前缀
+        LiteralSet suffixes;                ///< 路径后缀（扩展名、"/名称"）
+        SubstringAutomaton substrings;      ///< 路径子串（包含类规则、"/名称/"）
+        QVector<CompiledRule> expressions;  ///< 只能逐条匹配的正则表达式
+        GroupCounter counter;               ///< 索引查找（不含逐条匹配的正则表达式）的统计
+    };
+
+    RuleSet includeRules;                   ///< 启用的包含规则（通配符和正则表达式）
+    RuleSet excludeRules;                   ///< 启用的排除规则（通配符和正则表达式）
+    SubstringAutomaton excludeDirectories;  ///< 所有排除规则的"/名称/"，判断目录是否被明确排除
+    IgnoreRules ignoreRules;                ///< 启用的gitignore规则
+    bool fileTypeIncludeRule;               ///< 是否有文件类型包含规则
+    bool buildIncludeRule;                  ///< 是否有包含规则提到build
+    GroupCounter ignoreCounter;             ///< gitignore规则的统计
+    int ruleCount;                          ///< 规则列表中的规则数
+    std::unique_ptr<RuleCounter[]> ruleCounters; ///< 每条规则的统计，下标为规则下标
+
+    /**
+     * @brief 编译单条规则
+     * @param rule 过滤规则
+     * @param index 规则在规则列表中的下标
+     * @return 编译后的规则
+     */
+    static CompiledRule compile(const FileFilterUtil::FilterRule &rule, int index);
+
+    /**
+     * @brief 把编译后的规则放入对应的索引
+     * @param set 规则索引
+     * @param rule 编译后的规则
+     * @return 规则是否放入了哈希集合、自动机等索引（只逐条匹配的正则表达式返回false）
+     */
+    static bool addRule(RuleSet &set, const CompiledRule &rule);
+
+    /**
+     * @brief 按通配符和正则表达式规则检查条目
+     * @param path 规范化的路径
+     * @param folded 折叠大小写后的路径
+     * @param isDirectory 条目是否为目录
+     * @param profiling 是否统计规则命中和用时
+     * @return 应该被包含时返回true
+     */
+    bool matchesRules(const QString &path, QStringView folded, bool isDirectory, bool profiling) const;
+
+    /**
+     * @brief 查找路径匹配的规则
+     * @param set 规则索引
+     * @param path 规范化的路径
+     * @param folded 折叠大小写后的路径
+     * @param isDirectory 条目是否为目录
+     * @return 找到的第一条匹配规则的下标（不一定是最小的），没有匹配时返回-1
+     */
+    static int findRule(const RuleSet &set, const QString &path, QStringView folded, bool isDirectory);
+
+    /**
+     * @brief 在索引中查找路径匹配的规则，不检查逐条匹配的正则表达式
+     * @param set 规则索引
+     * @param folded 折叠大小写后的路径
+     * @param isDirectory 条目是否为目录
+     * @return 找到的规则下标，没有匹配时返回-1
+     */
+    static int findIndexedRule(const RuleSet &set, QStringView folded, bool isDirectory);
+
+    /**
+     * @brief 与findRule()相同，同时记录索引查找和每个正则表达式的用时以及命中的规则
+     * @param set 规则索引
+     * @param path 规范化的路径
+     * @param folded 折叠大小写后的路径
+     * @param isDirectory 条目是否为目录
+     * @return 找到的规则下标，没有匹配时返回-1
+     */
+    int profileRule(const RuleSet &set, const QString &path, QStringView folded, bool isDirectory) const;
+};
+
+#endif // FILTERMATCHER_H
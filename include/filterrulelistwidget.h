@@ -57,6 +57,14 @@ public:
      * @brief 清空规则列表
      */
     void clearRules();
+    
+    /**
+     * @brief 设置规则的命中统计，显示在每条规则后面
+     *
+     * 规则列表发生变化后统计不再对应，会被清除。
+     * @param statistics 按规则列表顺序排列的统计，为空时不显示
+     */
+    void setRuleStatistics(const QVector<FileFilterUtil::RuleStatistics> &statistics);
 
 signals:
     /**
@@ -108,11 +116,19 @@ private:
      * @return 显示文本
      */
     QString generateRuleItemText(const FileFilterUtil::FilterRule &rule) const;
+    
+    /**
+     * @brief 生成规则命中统计的显示文本
+     * @param statistics 规则的命中统计
+     * @return 显示文本
+     */
+    QString generateStatisticsText(const FileFilterUtil::RuleStatistics &statistics) const;
 
     // UI组件
     QLineEdit *patternEdit;           ///< 模式输入框
     QRadioButton *wildcardRadioButton; ///< 通配符单选按钮
     QRadioButton *regexRadioButton;   ///< 正则表达式单选按钮
+    QRadioButton *gitignoreRadioButton; ///< gitignore语法单选按钮
     QButtonGroup *matchTypeGroup;     ///< 匹配类型按钮组
     QComboBox *filterModeCombo;       ///< 过滤模式下拉框
     QPushButton *addButton;           ///< 添加按钮
@@ -121,6 +137,7 @@ private:
     QListWidget *rulesListWidget;     ///< 规则列表部件
     
     QList<FileFilterUtil::FilterRule> m_rules; ///< 过滤规则列表
+    QVector<FileFilterUtil::RuleStatistics> m_statistics; ///< 规则的命中统计，与m_rules一一对应
 };
 
 #endif // FILTERRULELISTWIDGET_H 
\ No newline at end of file
@@ -0,0 +1,148 @@
+/**
+ * @file filtertrace.h
+ * @brief 过滤决策跟踪的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef FILTERTRACE_H
+#define FILTERTRACE_H
+
+#include <QFlags>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * @class FilterTrace
+ * @brief 按类别记录过滤决策的环形缓冲区
+ *
+ * 只有定义了AIDOCTOOLS_FILTER_TRACE（CMake选项AIDOCTOOLS_FILTER_TRACE）时，
+ * FILTER_TRACE宏才会展开；否则宏为空，发布版本的扫描不承担任何开销。
+ * 编译进来之后，未启用的类别也只是一次原子读取和一个很少成立的分支。
+ *
+ * 每个决策记录为一条16字节的二进制记录，不格式化任何文本；路径只保存哈希值，
+ * 可以与导出的路径列表对照。缓冲区写满后从头覆盖，只保留最近的记录。
+ */
+class FilterTrace
+{
+public:
+    /**
+     * @brief 跟踪类别
+     */
+    enum Category {
+        Rules = 0x1,    ///< FilterMatcher中的规则匹配结果
+        Scanner = 0x2   ///< 读取器剪掉的目录
+    };
+    Q_DECLARE_FLAGS(Categories, Category)
+
+    /**
+     * @brief 决策事件
+     */
+    enum class Event : quint8 {
+        IncludeMatched,     ///< 匹配包含规则，包含
+        ExcludeMatched,     ///< 匹配排除规则，排除
+        BuildExcluded,      ///< build目录自动排除
+        DirectoryTraversed, ///< 存在文件类型包含规则，目录保留以便遍历
+        DefaultIncluded,    ///< 没有规则匹配，默认包含
+        DefaultExcluded,    ///< 有包含规则但都不匹配，默认排除
+        IgnoreMatched,      ///< 被gitignore规则忽略，排除
+        DirectoryPruned,    ///< 目录被排除，整个子树不再读取
+        SubtreeIncluded,    ///< 目录的整个子树被包含，条目不再逐个检查
+        SubtreeExcluded     ///< 目录的整个子树被排除，条目不再逐个检查
+    };
+
+    /**
+     * @brief 一条跟踪记录
+     */
+    struct Record {
+        qint64 timestamp;   ///< 距跟踪开始的纳秒数
+        quint32 pathHash;   ///< 路径UTF-16编码的FNV-1a哈希
+        qint16 rule;        ///< 规则在规则列表中的下标，无对应规则时为-1
+        quint8 category;    ///< 跟踪类别
+        quint8 event;       ///< 决策事件
+    };
+
+    /**
+     * @brief 判断跟踪是否编译进来
+     * @return 定义了AIDOCTOOLS_FILTER_TRACE时返回true
+     */
+    static constexpr bool isCompiledIn()
+    {
+#ifdef AIDOCTOOLS_FILTER_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief 设置启用的类别，首次启用时分配缓冲区
+     * @param categories 类别
+     */
+    static void setCategories(Categories categories);
+
+    /**
+     * @brief 判断类别是否启用
+     * @param category 类别
+     * @return 启用时返回true
+     */
+    static bool isEnabled(Category category)
+    {
+        return (enabledCategories.load(std::memory_order_relaxed) & category) != 0;
+    }
+
+    /**
+     * @brief 追加一条记录
+     * @param category 类别
+     * @param event 决策事件
+     * @param path 条目路径
+     * @param rule 规则下标，无对应规则时为-1
+     */
+    static void record(Category category, Event event, const QString &path, int rule = -1);
+
+    /**
+     * @brief 按时间顺序取出缓冲区中的记录
+     *
+     * 读取线程仍在写入时，正在被覆盖的记录可能不完整。
+     * @return 记录列表
+     */
+    static QVector<Record> snapshot();
+
+    /**
+     * @brief 把缓冲区中的记录以二进制格式写入设备
+     *
+     * 格式：8字节标识"AIDTRACE"、4字节版本号、4字节记录数，之后是各条记录，
+     * 均为本机字节序。
+     * @param device 已打开的输出设备
+     * @return 是否全部写入成功
+     */
+    static bool write(QIODevice *device);
+
+    /**
+     * @brief 清空缓冲区
+     */
+    static void clear();
+
+private:
+    static std::atomic<int> enabledCategories;  ///< 启用的类别
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(FilterTrace::Categories)
+
+#ifdef AIDOCTOOLS_FILTER_TRACE
+#define FILTER_TRACE(category, event, path, rule) \
+    do { \
+        if (Q_UNLIKELY(FilterTrace::isEnabled(category))) { \
+            FilterTrace::record(category, event, path, rule); \
+        } \
+    } while (false)
+#else
+#define FILTER_TRACE(category, event, path, rule) \
+    do { \
+    } while (false)
+#endif
+
+#endif // FILTERTRACE_H
@@ -0,0 +1,130 @@
+/**
+ * @file ignorerules.h
+ * @brief gitignore语法的规则集的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef IGNORERULES_H
+#define IGNORERULES_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @class IgnoreRules
+ * @brief 按gitignore语法编译的一组模式
+ *
+ * 支持的语法与git一致：
+ * - 空行和以#开头的行被忽略，行尾空格被去掉（用\转义的除外）
+ * - 以!开头的模式取反，重新包含之前被匹配的路径
+ * - 以/结尾的模式只匹配目录
+ * - 开头或中间含有/的模式相对于规则集的基准目录锚定，否则匹配任意层级的名称
+ * - *和?不匹配/，[...]匹配字符集合；位于开头、末尾或两个/之间的**匹配任意层目录
+ *
+ * 多个模式匹配同一路径时以最后一个为准。与git的默认设置（core.ignorecase=false）一致，
+ * 匹配默认区分大小写；需要时可以在构造时明确指定不区分大小写。
+ * 不含通配符的模式直接比较字符串，其余模式在编译时转换为锚定的正则表达式并完成优化，
+ * 匹配时只做字符串比较和正则匹配，不访问文件系统。
+ */
+class IgnoreRules
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param sensitivity 匹配是否区分大小写，对之后添加的模式生效
+     */
+    explicit IgnoreRules(Qt::CaseSensitivity sensitivity = Qt::CaseSensitive);
+
+    /**
+     * @brief 匹配结果
+     */
+    enum class Verdict {
+        Unmatched,  ///< 没有模式匹配
+        Matched,    ///< 最后匹配的是普通模式（gitignore中表示忽略）
+        Negated     ///< 最后匹配的是以!开头的模式
+    };
+
+    /**
+     * @brief 添加一行模式
+     * @param line gitignore中的一行
+     * @param source 模式来源的编号（如规则在规则列表中的下标），匹配时返回
+     * @param invert 为true时把结果取反，即普通模式按!模式处理，!模式按普通模式处理
+     * @return 是否添加了模式（空行和注释返回false）
+     */
+    bool addLine(const QString &line, int source = -1, bool invert = false);
+
+    /**
+     * @brief 添加多行模式
+     * @param lines gitignore的各行
+     * @param source 模式来源的编号
+     */
+    void addLines(const QStringList &lines, int source = -1);
+
+    /**
+     * @brief 判断是否没有任何模式
+     * @return 没有模式时返回true
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief 获取模式数
+     * @return 模式数
+     */
+    int size() const;
+
+    /**
+     * @brief 判断是否有可能忽略路径的模式
+     * @return 有不以!开头（取反后）的模式时返回true
+     */
+    bool canIgnore() const;
+
+    /**
+     * @brief 匹配一个路径
+     * @param relativePath 相对于基准目录的路径，分隔符为'/'，首尾不带'/'
+     * @param isDirectory 路径是否为目录
+     * @param source 非空时返回最后匹配的模式的来源编号
+     * @return 匹配结果
+     */
+    Verdict match(QStringView relativePath, bool isDirectory, int *source = nullptr) const;
+
+    /**
+     * @brief 判断路径或它的某一级父目录是否被匹配
+     *
+     * git不会进入被忽略的目录，其中的路径无法再被!模式重新包含；
+     * 逐条检查路径（而不是在遍历时剪枝）的调用方用它得到相同的结果。
+     * @param relativePath 相对于基准目录的路径
+     * @param isDirectory 路径是否为目录
+     * @return 路径本身或某一级父目录的结果为Matched时返回true
+     */
+    bool matchesWithParents(QStringView relativePath, bool isDirectory) const;
+
+private:
+    /**
+     * @brief 编译后的单个模式
+     */
+    struct Pattern {
+        QString literal;                ///< 不含通配符时的字面量
+        QRegularExpression expression;  ///< 含通配符时的锚定正则表达式
+        bool negated;                   ///< 是否取反
+        bool directoryOnly;             ///< 是否只匹配目录
+        bool anchored;                  ///< 是否匹配完整的相对路径（否则只匹配名称）
+        int source;                     ///< 来源编号
+    };
+
+    QVector<Pattern> patterns;  ///< 按添加顺序排列的模式
+    int ignoringPatterns = 0;   ///< 不取反的模式数
+    Qt::CaseSensitivity caseSensitivity; ///< 匹配是否区分大小写
+
+    /**
+     * @brief 把gitignore的通配符模式转换为正则表达式
+     * @param glob 通配符模式（已去掉!、首尾的/）
+     * @return 锚定的正则表达式
+     */
+    static QString globToRegularExpression(const QString &glob);
+};
+
+#endif // IGNORERULES_H
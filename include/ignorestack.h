@@ -0,0 +1,113 @@
+/**
+ * @file ignorestack.h
+ * @brief 按目录层级继承的忽略文件规则栈的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef IGNORESTACK_H
+#define IGNORESTACK_H
+
+#include "ignorerules.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class IgnoreStack
+ * @brief 一个目录中的忽略文件编译出的规则，连同所有祖先目录的规则组成的栈
+ *
+ * 每个节点只保存本目录的忽略文件（.gitignore、.ignore和.aidoctoolsignore，
+ * 后者优先），并指向最近的有忽略文件的祖先目录的节点。节点构造后不再修改，
+ * 没有忽略文件的子目录直接共享父目录的节点，同一个文件只解析一次。
+ *
+ * 与git一致，匹配时从最深的目录开始，第一个给出结果的规则集为准。
+ */
+class IgnoreStack
+{
+public:
+    /**
+     * @brief 获取扫描时识别的忽略文件名，按优先级从低到高排列
+     * @return 忽略文件名列表
+     */
+    static const QStringList &fileNames();
+
+    /**
+     * @brief 判断条目名是否为忽略文件
+     * @param name 条目名
+     * @return 是忽略文件时返回true
+     */
+    static bool isIgnoreFile(const QString &name);
+
+    /**
+     * @brief 读取一个目录中的忽略文件，压入规则栈
+     * @param parent 从祖先目录继承的规则栈（可为空）
+     * @param directory 规范化的目录路径，分隔符为'/'，以'/'结尾
+     * @param files 目录中存在的忽略文件名
+     * @return 新的规则栈；忽略文件都无法读取或没有任何模式时返回parent
+     */
+    static QSharedPointer<const IgnoreStack> push(const QSharedPointer<const IgnoreStack> &parent,
+                                                  const QString &directory, const QStringList &files);
+
+    /**
+     * @brief 检查条目是否被忽略
+     * @param path 规范化的路径，必须位于栈顶节点的目录之下
+     * @param isDirectory 条目是否为目录（目录路径可以以'/'结尾）
+     * @return 被忽略时返回true
+     */
+    bool isIgnored(const QString &path, bool isDirectory) const;
+
+private:
+    QSharedPointer<const IgnoreStack> parent;  ///< 祖先目录的规则栈
+    IgnoreRules rules;                         ///< 本目录的忽略文件编译出的规则
+    int baseLength = 0;                        ///< 本目录路径的长度，其后为相对于本目录的路径
+};
+
+/**
+ * @class IgnoreStackMap
+ * @brief 记录扫描过程中各目录的规则栈（线程安全）
+ *
+ * 只为含有忽略文件的目录保存节点，其他目录向上查找最近的祖先即可得到继承的栈。
+ * 遍历器只在父目录读取完成后才读取子目录，因此子目录进入时父目录的节点已经就绪。
+ */
+class IgnoreStackMap
+{
+public:
+    /**
+     * @brief 清空记录并设置扫描根目录
+     * @param rootDirectory 规范化的根目录路径，以'/'结尾
+     * @param complete 之后是否从根目录开始逐层进入各目录；为false时（如从快照恢复后
+     *                 只重新读取个别目录），进入目录前先从文件系统补上各级祖先目录的忽略文件
+     */
+    void reset(const QString &rootDirectory, bool complete);
+
+    /**
+     * @brief 进入一个目录，把其中的忽略文件压入继承的规则栈
+     *
+     * 重新读取同一目录时覆盖之前的记录；已读取的子目录的条目不会被重新判断。
+     * @param directory 规范化的目录路径，以'/'结尾
+     * @param files 目录中存在的忽略文件名
+     * @return 适用于本目录条目的规则栈，没有任何规则时为空
+     */
+    QSharedPointer<const IgnoreStack> enter(const QString &directory, const QStringList &files);
+
+private:
+    mutable QMutex mutex;   ///< 保护以下成员
+    QString root;           ///< 规范化的根目录路径
+    bool complete = true;   ///< 是否从根目录开始逐层进入
+    QHash<QString, QSharedPointer<const IgnoreStack>> stacks; ///< 含有忽略文件的目录的规则栈
+    QSet<QString> resolved; ///< complete为false时已经确定规则栈的目录
+
+    /**
+     * @brief 获取目录从祖先目录继承的规则栈
+     * @param directory 规范化的目录路径
+     * @return 规则栈，没有任何规则时为空
+     */
+    QSharedPointer<const IgnoreStack> inherited(const QString &directory);
+};
+
+#endif // IGNORESTACK_H
@@ -0,0 +1,120 @@
+/**
+ * @file literalset.h
+ * @brief 不区分大小写的字面量哈希集合的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef LITERALSET_H
+#define LITERALSET_H
+
+#include <QChar>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @class LiteralSet
+ * @brief 按大小写折叠后的字面量建立的开放寻址哈希表
+ *
+ * 每个字面量对应一个值（如规则下标）。除了完整匹配，还可以查找文本的某个前缀或后缀
+ * 是否在集合中：集合记录所有出现过的字面量长度，每种长度只查一次哈希表，
+ * 因此查找的代价取决于长度的种类数，而不是字面量的数量（如几百个扩展名通常只有几种长度）。
+ *
+ * 查找时传入的文本必须已经用foldCase()折叠，查找过程不分配内存。
+ * 折叠对ASCII字符按块（SSE2可用时每次8个UTF-16单元）处理，只有出现非ASCII字符时才查表。
+ */
+class LiteralSet
+{
+public:
+    /**
+     * @brief 折叠单个UTF-16字符的大小写，ASCII字符不查表
+     * @param c 字符
+     * @return 折叠后的字符
+     */
+    static char16_t foldCase(char16_t c)
+    {
+        if (c < 0x80) {
+            return (c >= u'A' && c <= u'Z') ? static_cast<char16_t>(c + 32) : c;
+        }
+        return static_cast<char16_t>(QChar::toCaseFolded(c));
+    }
+
+    /**
+     * @brief 折叠一段UTF-16文本的大小写
+     * @param text 文本
+     * @param length 文本长度
+     * @param folded 输出缓冲区，长度至少为length，可以与text相同
+     */
+    static void foldCase(const char16_t *text, qsizetype length, char16_t *folded);
+
+    /**
+     * @brief 折叠字符串的大小写
+     * @param text 字符串
+     * @return 折叠后的字符串
+     */
+    static QString foldCase(QStringView text);
+
+    /**
+     * @brief 添加字面量，已存在时保留先添加的值
+     * @param literal 字面量（不必预先折叠）
+     * @param value 对应的值，必须非负
+     */
+    void insert(QStringView literal, int value);
+
+    /**
+     * @brief 判断集合是否为空
+     * @return 为空时返回true
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief 查找与文本完全相同的字面量
+     * @param folded 已折叠的文本
+     * @return 对应的值，不存在时返回-1
+     */
+    int find(QStringView folded) const;
+
+    /**
+     * @brief 查找作为文本前缀的字面量（较短的优先）
+     * @param folded 已折叠的文本
+     * @return 对应的值，不存在时返回-1
+     */
+    int findPrefix(QStringView folded) const;
+
+    /**
+     * @brief 查找作为文本后缀的字面量（较短的优先）
+     * @param folded 已折叠的文本
+     * @return 对应的值，不存在时返回-1
+     */
+    int findSuffix(QStringView folded) const;
+
+private:
+    /**
+     * @brief 哈希表的槽位
+     */
+    struct Slot {
+        QString key;        ///< 折叠后的字面量
+        size_t hash = 0;    ///< key的哈希值
+        int value = -1;     ///< 对应的值，-1表示空槽位
+    };
+
+    QVector<Slot> slots;    ///< 槽位，数量为2的幂
+    int count = 0;          ///< 已占用的槽位数
+    QVector<int> lengths;   ///< 出现过的字面量长度，升序排列
+
+    /**
+     * @brief 查找槽位
+     * @param key 已折叠的字面量
+     * @param hash key的哈希值
+     * @return 找到的槽位或应插入的空槽位的下标
+     */
+    int slotIndex(QStringView key, size_t hash) const;
+
+    /**
+     * @brief 槽位数翻倍并重新插入所有字面量
+     */
+    void grow();
+};
+
+#endif // LITERALSET_H
@@ -13,7 +13,7 @@
 #include "filterrulelistwidget.h"
 
 #include <QMainWindow>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QLineEdit>
 #include <QSpinBox>
 #include <QPushButton>
@@ -23,6 +23,7 @@
 #include <QRadioButton>
 #include <QButtonGroup>
 #include <QDir>
+#include <QFile>
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QTextEdit>
@@ -74,14 +75,20 @@ private slots:
     /**
      * @brief 更新进度条槽函数
      * @param value 进度值（0-100）
+     * @param detail 进度说明
      */
-    void updateProgress(int value);
+    void updateProgress(int value, const QString &detail);
     
     /**
      * @brief 读取完成槽函数
      */
     void readingFinished();
     
+    /**
+     * @brief 监视到目录变化并已更新目录树后的槽函数
+     */
+    void directoryTreeUpdated();
+    
     /**
      * @brief 切换过滤选项槽函数
      * @param enabled 是否启用过滤
@@ -93,6 +100,11 @@ private slots:
      */
     void exportToTxtFile();
     
+    /**
+     * @brief 读取目录并边读取边导出为NDJSON、JSON或CSV
+     */
+    void exportScan();
+    
     /**
      * @brief 导入过滤规则槽函数
      */
@@ -165,6 +177,7 @@ private:
     QMenu *toolsMenu;            ///< 工具菜单
     QMenu *helpMenu;             ///< 帮助菜单
     QAction *exportAction;       ///< 导出动作
+    QAction *exportScanAction;   ///< 读取并导出动作
     QAction *importFilterAction; ///< 导入过滤规则动作
     QAction *styleSettingsAction; ///< 样式设置动作
     QAction *filterRulesAction;  ///< 过滤规则动作
@@ -185,9 +198,13 @@ private:
     QCheckBox *filterCheckBox;       ///< 过滤复选框
     FilterRuleListWidget *filterRuleListWidget; ///< 过滤规则列表部件
     QCheckBox *readFilesCheckBox;    ///< 读取文件复选框
+    QCheckBox *watchCheckBox;        ///< 监视目录变化复选框
+    QCheckBox *lazyCheckBox;         ///< 按需读取深层目录复选框
+    QCheckBox *rollupCheckBox;       ///< 统计目录大小复选框
+    QCheckBox *profileCheckBox;      ///< 统计过滤规则命中复选框
     QPushButton *startButton;        ///< 开始按钮
     QPushButton *cancelButton;       ///< 取消按钮
-    QTreeWidget *directoryTreeWidget; ///< 目录树控件
+    QTreeView *directoryTreeView;    ///< 目录树视图
     QTextEdit *directoryTextDisplay;  ///< 目录文本显示
     QProgressBar *progressBar;       ///< 进度条
     QLabel *statusLabel;             ///< 状态标签
@@ -197,6 +214,8 @@ private:
 
     // 目录树读取器
     DirectoryTreeReader *directoryReader; ///< 目录树读取器
+    QFile *scanExportFile;           ///< 正在写入的导出文件（没有导出时为空）
+    ScanExporter *scanExporter;      ///< 正在进行的流式导出（没有导出时为空）
 
     /**
      * @brief 设置UI组件
@@ -207,10 +226,12 @@ private:
      * @brief 设置菜单
      */
     void setupMenus();
-    void readDirectory(const QString &path, QTreeWidgetItem *parent, int currentDepth, int maxDepth);
+    
+    /**
+     * @brief 恢复上次读取的目录，存在扫描快照时立即显示目录树
+     */
+    void restoreLastDirectory();
     bool matchesFilter(const QString &fileName);
-    void populateTreeWidget(const QString &rootPath, int maxDepth);
-    QString generateTextRepresentation(QTreeWidgetItem *item, int level = 0);
     
     /**
      * @brief 检查文件是否匹配过滤规则
@@ -0,0 +1,103 @@
+/**
+ * @file progresstracker.h
+ * @brief 进度统计器的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef PROGRESSTRACKER_H
+#define PROGRESSTRACKER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+
+#include <atomic>
+
+class QTimer;
+
+/**
+ * @class ProgressTracker
+ * @brief 汇总多个工作线程进度并定时发布的统计器
+ *
+ * 工作线程只累加两个原子计数：总量（已发现的目录数或预计字节数）和完成量，
+ * 不发送任何信号。统计器在所属线程中以固定频率（约30Hz）读取计数，
+ * 计算百分比、吞吐量和剩余时间后发出一次progressUpdated()。
+ * 总量会随扫描不断增长，发布的百分比保证不会回退。
+ */
+class ProgressTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 计数单位
+     */
+    enum class Unit {
+        Directories,    ///< 目录数
+        Bytes           ///< 字节数
+    };
+
+    /**
+     * @brief 构造函数
+     * @param unit 计数单位，决定吞吐量的显示方式
+     * @param parent 父对象
+     */
+    explicit ProgressTracker(Unit unit, QObject *parent = nullptr);
+
+    /**
+     * @brief 清零计数并开始定时发布（在统计器所属线程中调用）
+     */
+    void start();
+
+    /**
+     * @brief 停止定时发布，并按最终计数发布一次
+     */
+    void finish();
+
+    /**
+     * @brief 增加总量（线程安全）
+     * @param amount 增加的数量
+     */
+    void addTotal(qint64 amount);
+
+    /**
+     * @brief 增加完成量（线程安全）
+     * @param amount 增加的数量
+     */
+    void addCompleted(qint64 amount);
+
+signals:
+    /**
+     * @brief 进度更新信号
+     * @param value 进度值（0-100）
+     * @param detail 完成量、吞吐量和预计剩余时间的文字说明
+     */
+    void progressUpdated(int value, const QString &detail);
+
+private slots:
+    /**
+     * @brief 读取计数并发布进度
+     */
+    void publish();
+
+private:
+    Unit unit;                          ///< 计数单位
+    std::atomic<qint64> total;          ///< 总量
+    std::atomic<qint64> completed;      ///< 完成量
+    QTimer *timer;                      ///< 发布定时器
+    QElapsedTimer elapsed;              ///< 自开始起的计时
+    qint64 lastCompleted;               ///< 上次发布时的完成量
+    qint64 lastElapsed;                 ///< 上次发布时的耗时（毫秒）
+    double rate;                        ///< 平滑后的吞吐量（每秒）
+    int lastValue;                      ///< 上次发布的进度值
+
+    /**
+     * @brief 格式化数量
+     * @param amount 数量
+     * @return 带单位的文字
+     */
+    QString formatAmount(qint64 amount) const;
+};
+
+#endif // PROGRESSTRACKER_H
@@ -0,0 +1,181 @@
+/**
+ * @file scanexporter.h
+ * @brief 扫描结果流式导出器的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef SCANEXPORTER_H
+#define SCANEXPORTER_H
+
+#include "directorywalker.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class ScanExporter
+ * @brief 在读取过程中把条目逐条写出的导出器
+ *
+ * 每个条目一条记录：路径、类型、大小、修改时间和深度（根目录为0）。
+ * 支持三种格式：
+ * - NDJSON：每行一个JSON对象，按读取顺序输出
+ * - JSON：嵌套的目录对象，子条目放在children数组中，要求按深度优先顺序读取
+ * - CSV：带表头的逗号分隔表格，按读取顺序输出
+ *
+ * 导出器由读取线程驱动，每读取完一个目录就写出它的条目，不保存整个文档；
+ * 嵌套JSON只需保留当前路径上各目录的条目。输出先写入缓冲区，
+ * 积累到一定大小或调用flush()时写入设备。
+ */
+class ScanExporter
+{
+public:
+    /**
+     * @brief 导出格式
+     */
+    enum class Format {
+        Ndjson,     ///< 每行一个JSON对象
+        Json,       ///< 嵌套JSON
+        Csv         ///< CSV表格
+    };
+
+    /**
+     * @brief 构造函数
+     * @param device 已打开的输出设备，由调用方持有，读取期间只由读取线程写入
+     * @param format 导出格式
+     */
+    ScanExporter(QIODevice *device, Format format);
+
+    /**
+     * @brief 按文件扩展名推断导出格式
+     * @param fileName 文件名
+     * @param fallback 无法识别时使用的格式
+     * @return 导出格式
+     */
+    static Format formatForFile(const QString &fileName, Format fallback = Format::Ndjson);
+
+    /**
+     * @brief 获取导出格式
+     * @return 导出格式
+     */
+    Format format() const;
+
+    /**
+     * @brief 判断是否要求按深度优先顺序读取
+     * @return 嵌套JSON时返回true
+     */
+    bool requiresDepthFirst() const;
+
+    /**
+     * @brief 开始导出，写出表头和根目录记录
+     * @param rootPath 根目录路径
+     */
+    void begin(const QString &rootPath);
+
+    /**
+     * @brief 写出一个目录的条目
+     *
+     * 条目中会继续读取的子目录（槽位有效）稍后会作为目录出现在另一次调用中。
+     * @param nodeId 目录对应的节点下标（根目录为0）
+     * @param firstChild 第一个条目的节点下标
+     * @param entries 目录条目
+     */
+    void addListing(int nodeId, int firstChild, const QVector<DirectoryWalker::Entry> &entries);
+
+    /**
+     * @brief 结束导出，补全尚未闭合的结构并写入剩余的缓冲区
+     *
+     * 读取被取消时同样调用，输出仍是格式完整的文档。
+     */
+    void finish();
+
+    /**
+     * @brief 把缓冲区写入设备
+     */
+    void flush();
+
+    /**
+     * @brief 判断写入是否出错
+     * @return 出错时返回true
+     */
+    bool hasError() const;
+
+    /**
+     * @brief 获取已写出的记录数
+     * @return 记录数
+     */
+    qint64 recordCount() const;
+
+private:
+    /**
+     * @brief 等待读取的目录
+     */
+    struct PendingDirectory {
+        QString path;   ///< 目录路径
+        int depth;      ///< 目录深度
+    };
+
+    /**
+     * @brief 嵌套JSON中正在输出子条目的目录
+     */
+    struct Frame {
+        QVector<DirectoryWalker::Entry> entries;    ///< 目录条目
+        QString path;       ///< 目录路径
+        int depth;          ///< 条目的深度
+        int firstChild;     ///< 第一个条目的节点下标
+        int next;           ///< 下一个要输出的条目
+    };
+
+    QIODevice *device;      ///< 输出设备
+    Format exportFormat;    ///< 导出格式
+    QByteArray buffer;      ///< 输出缓冲区
+    bool error;             ///< 是否写入出错
+    bool finished;          ///< 是否已结束
+    qint64 records;         ///< 已写出的记录数
+    QHash<qint32, PendingDirectory> pendingDirectories; ///< 已写出记录、等待读取的目录
+    QVector<Frame> frames;  ///< 嵌套JSON中从根到当前目录的路径
+    int openDirectories;    ///< 嵌套JSON中尚未闭合的目录对象数
+
+    /**
+     * @brief 按平面格式（NDJSON或CSV）写出一条记录
+     * @param path 路径
+     * @param entry 条目
+     * @param depth 深度
+     */
+    void writeRecord(const QString &path, const DirectoryWalker::Entry &entry, int depth);
+
+    /**
+     * @brief 写出记录的各字段（JSON对象内部，不含花括号）
+     * @param path 路径
+     * @param entry 条目
+     * @param depth 深度
+     */
+    void writeJsonFields(const QString &path, const DirectoryWalker::Entry &entry, int depth);
+
+    /**
+     * @brief 嵌套JSON：继续输出栈顶目录的条目，直到遇到需要等待读取的子目录
+     */
+    void advance();
+
+    /**
+     * @brief 缓冲区超过一定大小时写入设备
+     */
+    void flushIfNeeded();
+
+    /**
+     * @brief 追加JSON字符串（含引号和转义）
+     * @param text 文本
+     */
+    void appendJsonString(const QString &text);
+
+    /**
+     * @brief 追加CSV字段，必要时加引号
+     * @param text 文本
+     */
+    void appendCsvField(const QString &text);
+};
+
+#endif // SCANEXPORTER_H
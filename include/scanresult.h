@@ -0,0 +1,149 @@
+/**
+ * @file scanresult.h
+ * @brief 扫描结果存储的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef SCANRESULT_H
+#define SCANRESULT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class ScanResult
+ * @brief 紧凑的扫描结果存储
+ *
+ * 每个条目是一个20字节的节点，只记录父节点下标和自身名称；名称以UTF-8形式
+ * 集中存放在一块字符串区，每个名称只存一次。同一目录的子节点在数组中连续存放。
+ * 完整路径不保存，需要时沿父节点向上拼接。目录树模型和文件合并器共用这一结构。
+ *
+ * 可选的汇总统计（文件数、总大小、最新修改时间）保存在与节点数组平行的rollups中，
+ * 未统计时rollups为空，节点本身的布局不受影响。
+ */
+class ScanResult
+{
+public:
+    /**
+     * @brief 节点标志位
+     */
+    enum NodeFlag : quint8 {
+        DirectoryFlag = 0x01,   ///< 节点是目录
+        ListedFlag = 0x02       ///< 目录的子节点范围已确定
+    };
+
+    /**
+     * @brief 紧凑节点（20字节）
+     */
+    struct Node {
+        qint32 parent;       ///< 父节点下标（根节点为-1）
+        qint32 firstChild;   ///< 第一个子节点下标（-1表示没有子节点）
+        qint32 childCount;   ///< 子节点数量
+        quint32 nameOffset;  ///< 名称在字符串区中的偏移
+        quint16 nameLength;  ///< 名称的UTF-8字节数
+        quint8 flags;        ///< 节点标志位
+        quint8 reserved;     ///< 保留
+    };
+
+    /**
+     * @brief 节点的汇总统计（24字节）
+     *
+     * 文件节点是自身的大小和修改时间，文件数为1；目录节点是整个子树的合计，
+     * 子树尚未读取完成时文件数为-1。
+     */
+    struct Rollup {
+        qint64 files;        ///< 文件数（-1表示尚未确定）
+        qint64 bytes;        ///< 总字节数
+        qint64 modified;     ///< 最新修改时间（自纪元起的毫秒数，0表示没有文件）
+
+        bool isKnown() const { return files >= 0; }
+
+        /**
+         * @brief 合并一个子节点的统计
+         * @param other 子节点的统计
+         */
+        void add(const Rollup &other)
+        {
+            files += other.files;
+            bytes += other.bytes;
+            modified = qMax(modified, other.modified);
+        }
+
+        static Rollup unknown() { return Rollup{-1, 0, 0}; }
+        static Rollup empty() { return Rollup{0, 0, 0}; }
+        static Rollup file(qint64 size, qint64 modified) { return Rollup{1, size, modified}; }
+    };
+
+    QVector<Node> nodes;    ///< 扁平节点数组，下标0为根节点
+    QByteArray names;       ///< UTF-8名称字符串区
+    QString rootPath;       ///< 根目录路径
+    QVector<Rollup> rollups; ///< 与nodes平行的汇总统计（未统计时为空，可能短于nodes）
+
+    /**
+     * @brief 清空并只保留根节点
+     * @param rootPath 根目录路径
+     * @param rootName 根节点名称
+     */
+    void reset(const QString &rootPath, const QString &rootName);
+
+    /**
+     * @brief 清空所有节点
+     */
+    void clear();
+
+    /**
+     * @brief 追加一个子节点
+     *
+     * 同一目录的子节点必须连续追加，中间不能插入其他目录的子节点。
+     * @param parent 父节点下标
+     * @param name 名称
+     * @param isDir 是否为目录
+     * @return 新节点下标
+     */
+    int appendChild(int parent, const QString &name, bool isDir);
+
+    /**
+     * @brief 获取节点数量
+     * @return 节点数量
+     */
+    int nodeCount() const;
+
+    /**
+     * @brief 获取节点名称
+     * @param node 节点下标
+     * @return 名称
+     */
+    QString name(int node) const;
+
+    /**
+     * @brief 获取节点名称的UTF-8字节（不复制，下一次修改前有效）
+     * @param node 节点下标
+     * @return 名称
+     */
+    QByteArray nameUtf8(int node) const;
+
+    /**
+     * @brief 判断节点是否为目录
+     * @param node 节点下标
+     * @return 如果是目录返回true
+     */
+    bool isDirectory(int node) const;
+
+    /**
+     * @brief 获取节点的汇总统计
+     * @param node 节点下标
+     * @return 统计结果，没有统计时返回文件数为-1的结果
+     */
+    Rollup rollup(int node) const;
+
+    /**
+     * @brief 按需拼接节点的完整路径
+     * @param node 节点下标
+     * @return 完整路径
+     */
+    QString filePath(int node) const;
+};
+
+#endif // SCANRESULT_H
@@ -0,0 +1,135 @@
+/**
+ * @file scansnapshot.h
+ * @brief 目录扫描快照的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef SCANSNAPSHOT_H
+#define SCANSNAPSHOT_H
+
+#include "directorytreemodel.h"
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+/**
+ * @class ScanSnapshot
+ * @brief 目录扫描快照
+ *
+ * 把一次扫描得到的节点数组、名称字符串区和已读取目录的修改时间按原样写入一个二进制文件，
+ * 下次打开同一根目录时通过内存映射直接读取，无需重新遍历目录树。
+ *
+ * 文件布局（本机字节序，各段按8字节对齐）：
+ * 文件头、根目录路径（UTF-8）、节点数组、名称字符串区、目录修改时间表。
+ * 文件头中的魔数、版本号、字节序标记和节点大小任一不符时快照被视为无效。
+ */
+class ScanSnapshot
+{
+public:
+    /**
+     * @brief 已读取目录的修改时间
+     */
+    struct DirectoryTime {
+        qint32 node;        ///< 目录节点下标
+        qint32 reserved;    ///< 保留
+        qint64 modified;    ///< 读取时的修改时间（自纪元起的毫秒数）
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    ScanSnapshot();
+
+    /**
+     * @brief 析构函数，解除映射
+     */
+    ~ScanSnapshot();
+
+    ScanSnapshot(const ScanSnapshot &) = delete;
+    ScanSnapshot &operator=(const ScanSnapshot &) = delete;
+
+    /**
+     * @brief 获取快照文件的存放路径
+     * @param key 区分扫描参数的键（根目录、深度、过滤规则等）
+     * @return 缓存目录下的文件路径
+     */
+    static QString snapshotFilePath(const QByteArray &key);
+
+    /**
+     * @brief 写入快照（先写临时文件再替换，写入失败不会破坏旧快照）
+     * @param filePath 文件路径
+     * @param rootPath 根目录路径
+     * @param nodes 紧凑排列的节点数组
+     * @param names 名称字符串区
+     * @param directoryTimes 已读取目录的修改时间
+     * @return 是否写入成功
+     */
+    static bool write(const QString &filePath, const QString &rootPath,
+                      const QVector<DirectoryTreeModel::Node> &nodes, const QByteArray &names,
+                      const QVector<DirectoryTime> &directoryTimes);
+
+    /**
+     * @brief 映射并校验快照文件
+     * @param filePath 文件路径
+     * @return 快照有效时返回true
+     */
+    bool open(const QString &filePath);
+
+    /**
+     * @brief 获取根目录路径
+     * @return 根目录路径
+     */
+    QString rootPath() const;
+
+    /**
+     * @brief 获取节点数组（指向映射内存）
+     * @return 节点数组首地址
+     */
+    const DirectoryTreeModel::Node *nodes() const;
+
+    /**
+     * @brief 获取节点数量
+     * @return 节点数量
+     */
+    int nodeCount() const;
+
+    /**
+     * @brief 获取名称字符串区（指向映射内存）
+     * @return 字符串区首地址
+     */
+    const char *names() const;
+
+    /**
+     * @brief 获取名称字符串区大小
+     * @return 字节数
+     */
+    quint32 nameBytes() const;
+
+    /**
+     * @brief 获取目录修改时间表（指向映射内存）
+     * @return 修改时间表首地址
+     */
+    const DirectoryTime *directoryTimes() const;
+
+    /**
+     * @brief 获取目录修改时间表的条目数
+     * @return 条目数
+     */
+    int directoryTimeCount() const;
+
+private:
+    QFile file;                             ///< 快照文件
+    uchar *mapped;                          ///< 映射地址
+    QString root;                           ///< 根目录路径
+    const DirectoryTreeModel::Node *nodeData; ///< 节点数组
+    int nodeTotal;                          ///< 节点数量
+    const char *nameData;                   ///< 名称字符串区
+    quint32 nameSize;                       ///< 名称字符串区大小
+    const DirectoryTime *timeData;          ///< 目录修改时间表
+    int timeTotal;                          ///< 目录修改时间表条目数
+};
+
+#endif // SCANSNAPSHOT_H
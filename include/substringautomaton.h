@@ -0,0 +1,98 @@
+/**
+ * @file substringautomaton.h
+ * @brief 多模式子串匹配自动机的定义
+ * @author AIDocTools
+ * @date 2023
+ */
+
+#ifndef SUBSTRINGAUTOMATON_H
+#define SUBSTRINGAUTOMATON_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @class SubstringAutomaton
+ * @brief 不区分大小写的Aho-Corasick自动机
+ *
+ * 所有子串模式在build()时合并为一棵字典树并计算失败链接，
+ * 之后只需扫描一遍文本就能判断是否包含其中任意一个模式，
+ * 代价与模式数量无关。每个模式可以标记为只对目录生效。
+ *
+ * 查找时传入的文本必须已经用LiteralSet::foldCase()折叠，查找过程不分配内存。
+ * build()之后不再修改，可以在多个线程之间共享。
+ */
+class SubstringAutomaton
+{
+public:
+    /**
+     * @brief 添加模式（需在build()之前调用）
+     * @param literal 子串（不必预先折叠）
+     * @param value 对应的值，必须非负
+     * @param directoryOnly 是否只在查找目录路径时生效
+     */
+    void add(QStringView literal, int value, bool directoryOnly);
+
+    /**
+     * @brief 构建自动机
+     */
+    void build();
+
+    /**
+     * @brief 判断是否没有任何模式
+     * @return 没有模式时返回true
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief 查找文本中出现的模式
+     * @param folded 已折叠的文本
+     * @param isDirectory 文本是否为目录路径，为false时跳过只对目录生效的模式
+     * @return 最先结束的一个模式对应的值，都没有出现时返回-1
+     */
+    int find(QStringView folded, bool isDirectory) const;
+
+private:
+    /**
+     * @brief 自动机的状态
+     */
+    struct Node {
+        int firstEdge = 0;      ///< 第一条转移在edges中的下标
+        int edgeCount = 0;      ///< 转移数
+        int fail = 0;           ///< 失败链接
+        int anyValue = -1;      ///< 在此结束的任意模式的值（含失败链接上的）
+        int fileValue = -1;     ///< 在此结束的、对文件也生效的模式的值
+    };
+
+    /**
+     * @brief 状态转移，同一状态的转移按字符升序排列
+     */
+    struct Edge {
+        char16_t c;     ///< 字符
+        int target;     ///< 目标状态
+    };
+
+    /**
+     * @brief 等待构建的模式
+     */
+    struct Pattern {
+        QString literal;        ///< 折叠后的子串
+        int value;              ///< 对应的值
+        bool directoryOnly;     ///< 是否只对目录生效
+    };
+
+    QVector<Pattern> patterns;  ///< 已添加的模式
+    QVector<Node> nodes;        ///< 状态，0为初始状态
+    QVector<Edge> edges;        ///< 所有状态的转移
+
+    /**
+     * @brief 查找状态的转移
+     * @param state 状态
+     * @param c 字符
+     * @return 目标状态，没有转移时返回-1
+     */
+    int transition(int state, char16_t c) const;
+};
+
+#endif // SUBSTRINGAUTOMATON_H
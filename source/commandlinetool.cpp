@@ -0,0 +1,345 @@
+#include "commandlinetool.h"
+#include "directorytreereader.h"
+#include "filemerger.h"
+#include "filtertrace.h"
+#include "scanexporter.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QLocale>
+
+#include <cstdio>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace {
+// 子命令
+const char *const ScanCommand = "scan";
+const char *const TreeCommand = "tree";
+const char *const MergeCommand = "merge";
+const char *const ExportCommand = "export";
+// 与界面一致的默认搜索深度
+const int DefaultDepth = 3;
+}
+
+bool CommandLineTool::isCommandLine(int argc, char *argv[])
+{
+    if (argc < 2) {
+        return false;
+    }
+    const QByteArray command(argv[1]);
+    return command == ScanCommand || command == TreeCommand || command == MergeCommand || command == ExportCommand;
+}
+
+int CommandLineTool::run(const QStringList &arguments)
+{
+    attachConsole();
+
+    parser.setApplicationDescription("AIDocTools 命令行模式：读取目录树或合并文本文件，结果写入标准输出或文件");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command",
+                                 "子命令：scan（统计）、tree（目录树文本）、export（NDJSON/JSON/CSV）或 merge（合并文件）");
+    parser.addPositionalArgument("directory", "根目录");
+
+    // 先解析出子命令，再加入该子命令的选项
+    parser.parse(arguments);
+    const QString command = parser.positionalArguments().value(0);
+
+    parser.addOption(QCommandLineOption({"d", "depth"}, "最大搜索深度（默认3）", "n", QString::number(DefaultDepth)));
+    parser.addOption(QCommandLineOption({"o", "output"}, "输出文件，默认写入标准输出", "file"));
+    parser.addOption(QCommandLineOption("dedupe-hard-links", "同一文件的多个硬链接只保留一个"));
+    parser.addOption(QCommandLineOption("no-ignore-files", "不读取各级目录中的.gitignore、.ignore和.aidoctoolsignore"));
+    if (command == MergeCommand) {
+        addMergeOptions();
+    } else {
+        addTreeOptions();
+    }
+    if (FilterTrace::isCompiledIn() && command != MergeCommand) {
+        parser.addOption(QCommandLineOption("trace", "记录过滤决策，读取结束后以二进制格式写入该文件", "file"));
+    }
+    if (command == ExportCommand) {
+        parser.addOption(QCommandLineOption("format", "导出格式：ndjson、json或csv，默认按输出文件扩展名，否则为ndjson",
+                                            "format"));
+    }
+
+    parser.process(arguments);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2) {
+        printError("需要指定子命令和根目录，使用 --help 查看用法");
+        return UsageError;
+    }
+
+    const QString rootPath = QDir::cleanPath(QDir(positional.at(1)).absolutePath());
+    if (!QDir(rootPath).exists()) {
+        printError(QString("目录不存在: %1").arg(positional.at(1)));
+        return RuntimeError;
+    }
+
+    if (command == MergeCommand) {
+        return runMerge(rootPath);
+    }
+    
+    const bool trace = FilterTrace::isCompiledIn() && parser.isSet("trace");
+    if (trace) {
+        FilterTrace::setCategories(FilterTrace::Rules | FilterTrace::Scanner);
+    }
+    const int exitCode = command == ExportCommand ? runExport(rootPath) : runTree(rootPath, command == TreeCommand);
+    if (trace) {
+        QFile traceFile(parser.value("trace"));
+        if (!traceFile.open(QIODevice::WriteOnly) || !FilterTrace::write(&traceFile)) {
+            printError(QString("无法写入跟踪记录: %1").arg(parser.value("trace")));
+            return RuntimeError;
+        }
+    }
+    return exitCode;
+}
+
+void CommandLineTool::addTreeOptions()
+{
+    parser.addOption(QCommandLineOption("no-files", "只读取目录，不读取文件名"));
+    parser.addOption(QCommandLineOption("exclude", "排除匹配的文件或目录（可重复）", "pattern"));
+    parser.addOption(QCommandLineOption("include", "只包含匹配的文件（可重复）", "pattern"));
+    parser.addOption(QCommandLineOption("regex", "--exclude/--include按正则表达式匹配，默认为通配符"));
+    parser.addOption(QCommandLineOption("gitignore", "--exclude/--include按gitignore语法匹配（相对于根目录，支持!、**和目录规则）"));
+    parser.addOption(QCommandLineOption("depth-first", "按深度优先顺序读取，默认广度优先"));
+    parser.addOption(QCommandLineOption("rollups", "统计各目录的文件数、总大小和最新修改时间"));
+    parser.addOption(QCommandLineOption("snapshot", "使用并更新扫描快照，默认每次都完整读取"));
+}
+
+void CommandLineTool::addMergeOptions()
+{
+    parser.addOption(QCommandLineOption("filter", "文件名过滤模式，如 *.cpp;*.h", "pattern"));
+    parser.addOption(QCommandLineOption("regex", "--filter按正则表达式匹配，默认为通配符"));
+    parser.addOption(QCommandLineOption("rule", "文件包含规则，gitignore语法（可重复）", "pattern"));
+    parser.addOption(QCommandLineOption("header", "文件头模板，可包含{filename}、{index}、{path}", "template"));
+    parser.addOption(QCommandLineOption("separator", "文件之间的分隔符", "text", "----------"));
+    parser.addOption(QCommandLineOption("no-separator", "文件之间不添加分隔符"));
+    parser.addOption(QCommandLineOption("extract", "只保留匹配该正则表达式的内容", "regex"));
+}
+
+int CommandLineTool::runTree(const QString &rootPath, bool renderTree)
+{
+    int depth = 0;
+    if (!readDepth(depth)) {
+        return UsageError;
+    }
+
+    DirectoryTreeReader reader;
+    configureReader(reader, depth);
+
+    QElapsedTimer timer;
+    timer.start();
+    readAndWait(reader, rootPath);
+    const qint64 elapsed = timer.elapsed();
+
+    QFile output;
+    if (!openOutput(output)) {
+        return RuntimeError;
+    }
+
+    if (renderTree) {
+        if (!reader.writeTextRepresentation(&output)) {
+            printError(QString("写入失败: %1").arg(output.errorString()));
+            return RuntimeError;
+        }
+        return Success;
+    }
+
+    const ScanResult &result = reader.model()->scanResult();
+    qint64 directories = 0;
+    for (const ScanResult::Node &node : result.nodes) {
+        directories += (node.flags & ScanResult::DirectoryFlag) ? 1 : 0;
+    }
+
+    QString summary;
+    summary += QString("根目录: %1\n").arg(rootPath);
+    summary += QString("目录数: %1\n").arg(directories);
+    summary += QString("文件数: %1\n").arg(result.nodeCount() - directories);
+    const ScanResult::Rollup total = result.rollup(0);
+    if (total.isKnown()) {
+        summary += QString("总大小: %1（%2字节）\n").arg(QLocale().formattedDataSize(total.bytes)).arg(total.bytes);
+    }
+    summary += QString("用时: %1毫秒\n").arg(elapsed);
+
+    const QByteArray bytes = summary.toUtf8();
+    if (output.write(bytes) != bytes.size()) {
+        printError(QString("写入失败: %1").arg(output.errorString()));
+        return RuntimeError;
+    }
+    return Success;
+}
+
+int CommandLineTool::runExport(const QString &rootPath)
+{
+    int depth = 0;
+    if (!readDepth(depth)) {
+        return UsageError;
+    }
+
+    const QString formatName = parser.value("format").toLower();
+    ScanExporter::Format format = ScanExporter::formatForFile(parser.value("output"));
+    if (formatName == "ndjson") {
+        format = ScanExporter::Format::Ndjson;
+    } else if (formatName == "json") {
+        format = ScanExporter::Format::Json;
+    } else if (formatName == "csv") {
+        format = ScanExporter::Format::Csv;
+    } else if (!formatName.isEmpty()) {
+        printError(QString("未知的导出格式: %1").arg(parser.value("format")));
+        return UsageError;
+    }
+
+    // 先打开输出，记录在读取过程中就开始写出
+    QFile output;
+    if (!openOutput(output)) {
+        return RuntimeError;
+    }
+
+    DirectoryTreeReader reader;
+    configureReader(reader, depth);
+    ScanExporter exporter(&output, format);
+    reader.setExporter(&exporter);
+    readAndWait(reader, rootPath);
+
+    if (exporter.hasError()) {
+        printError(QString("写入失败: %1").arg(output.errorString()));
+        return RuntimeError;
+    }
+    return Success;
+}
+
+int CommandLineTool::runMerge(const QString &rootPath)
+{
+    int depth = 0;
+    if (!readDepth(depth)) {
+        return UsageError;
+    }
+
+    FileMerger merger;
+    merger.setRootPath(rootPath);
+    merger.setMaxDepth(depth);
+    merger.setFileFilter(parser.value("filter"), parser.isSet("regex"));
+    merger.setFilterRules(parser.values("rule"));
+    merger.setHeaderTemplate(parser.value("header"));
+    merger.setSeparator(!parser.isSet("no-separator"), parser.value("separator"));
+    merger.setExtractionRule(parser.value("extract"), parser.isSet("extract"));
+    merger.setDeduplicateHardLinks(parser.isSet("dedupe-hard-links"));
+    merger.setIgnoreFilesEnabled(!parser.isSet("no-ignore-files"));
+
+    int fileCount = 0;
+    QEventLoop loop;
+    QObject::connect(&merger, &FileMerger::mergingFinished, &loop, [&loop, &fileCount](int count) {
+        fileCount = count;
+        loop.quit();
+    });
+    merger.startMerging();
+    loop.exec();
+    if (fileCount == 0) {
+        printError("没有找到匹配的文件");
+    }
+
+    QFile output;
+    if (!openOutput(output)) {
+        return RuntimeError;
+    }
+
+    const QByteArray bytes = merger.getMergedText().toUtf8();
+    if (output.write(bytes) != bytes.size()) {
+        printError(QString("写入失败: %1").arg(output.errorString()));
+        return RuntimeError;
+    }
+    return Success;
+}
+
+void CommandLineTool::configureReader(DirectoryTreeReader &reader, int depth) const
+{
+    reader.setMaxDepth(depth);
+    reader.setReadFiles(!parser.isSet("no-files"));
+    reader.setScanOrder(parser.isSet("depth-first") ? DirectoryWalker::Order::DepthFirst
+                                                    : DirectoryWalker::Order::BreadthFirst);
+    reader.setDeduplicateHardLinks(parser.isSet("dedupe-hard-links"));
+    reader.setIgnoreFilesEnabled(!parser.isSet("no-ignore-files"));
+    reader.setComputeRollups(parser.isSet("rollups"));
+    reader.setSnapshotEnabled(parser.isSet("snapshot"));
+    reader.setFilterRules(filterRules());
+}
+
+void CommandLineTool::readAndWait(DirectoryTreeReader &reader, const QString &rootPath)
+{
+    // 读取结果以排队方式送达模型，在本地事件循环中等待读取完成
+    QEventLoop loop;
+    QObject::connect(&reader, &DirectoryTreeReader::readingFinished, &loop, &QEventLoop::quit);
+    reader.read(rootPath);
+    loop.exec();
+}
+
+QList<FileFilterUtil::FilterRule> CommandLineTool::filterRules() const
+{
+    FileFilterUtil::MatchType matchType = FileFilterUtil::MatchType::Wildcard;
+    if (parser.isSet("gitignore")) {
+        matchType = FileFilterUtil::MatchType::Gitignore;
+    } else if (parser.isSet("regex")) {
+        matchType = FileFilterUtil::MatchType::Regex;
+    }
+
+    QList<FileFilterUtil::FilterRule> rules;
+    for (const QString &pattern : parser.values("exclude")) {
+        rules.append(FileFilterUtil::FilterRule(pattern, matchType, FileFilterUtil::FilterMode::Exclude));
+    }
+    for (const QString &pattern : parser.values("include")) {
+        rules.append(FileFilterUtil::FilterRule(pattern, matchType, FileFilterUtil::FilterMode::Include));
+    }
+    return rules;
+}
+
+bool CommandLineTool::openOutput(QFile &output) const
+{
+    const QString filePath = parser.value("output");
+    bool opened = false;
+    if (filePath.isEmpty()) {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    } else {
+        output.setFileName(filePath);
+        opened = output.open(QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        printError(QString("无法打开输出: %1").arg(filePath.isEmpty() ? QString("标准输出") : filePath));
+    }
+    return opened;
+}
+
+bool CommandLineTool::readDepth(int &depth) const
+{
+    bool ok = false;
+    depth = parser.value("depth").toInt(&ok);
+    if (!ok || depth < 1) {
+        printError(QString("无效的深度: %1").arg(parser.value("depth")));
+        return false;
+    }
+    return true;
+}
+
+void CommandLineTool::attachConsole()
+{
+#ifdef Q_OS_WIN
+    // 程序按窗口程序链接，从控制台启动时标准输出没有绑定；已被重定向的输出保持不变
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        if (!GetStdHandle(STD_OUTPUT_HANDLE)) {
+            std::freopen("CONOUT$", "w", stdout);
+        }
+        if (!GetStdHandle(STD_ERROR_HANDLE)) {
+            std::freopen("CONOUT$", "w", stderr);
+        }
+    }
+#endif
+}
+
+void CommandLineTool::printError(const QString &message)
+{
+    std::fprintf(stderr, "%s\n", qUtf8Printable(message));
+}
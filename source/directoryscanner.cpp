@@ -0,0 +1,234 @@
+#include "directoryscanner.h"
+#include "ignorestack.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+// getdents64返回的记录格式，glibc没有公开该结构体
+struct LinuxDirent64 {
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+// 单次getdents64读取的缓冲区大小
+const int DirentBufferSize = 32 * 1024;
+
+qint64 toMSecs(const struct timespec &time)
+{
+    return static_cast<qint64>(time.tv_sec) * 1000 + time.tv_nsec / 1000000;
+}
+
+// 通过stat确定符号链接或未知类型条目的实际类型和标识，返回false表示应跳过该条目
+bool resolveEntryType(int dirFd, const char *name, DirectoryScanner::EntryType &type, DirectoryScanner::FileId &id,
+                      struct stat &st)
+{
+    if (fstatat(dirFd, name, &st, 0) != 0) {
+        // 失效的符号链接在QDir中属于系统条目，不列出
+        return false;
+    }
+    // 符号链接的目标可能在其他设备上，使用目标自身的设备号
+    id = DirectoryScanner::FileId(static_cast<quint64>(st.st_dev), static_cast<quint64>(st.st_ino));
+    if (S_ISDIR(st.st_mode)) {
+        type = DirectoryScanner::EntryType::Directory;
+        return true;
+    }
+    if (S_ISREG(st.st_mode)) {
+        type = DirectoryScanner::EntryType::File;
+        return true;
+    }
+    return false;
+}
+}
+#endif
+
+bool DirectoryScanner::scan(const QString &path, bool includeFiles, QVector<Entry> &entries,
+                            qint64 *modified, FileId *directoryId, bool fileMetadata, QStringList *ignoreFiles)
+{
+#ifdef Q_OS_LINUX
+    const QByteArray encodedPath = QFile::encodeName(path);
+    const int dirFd = openat(AT_FDCWD, encodedPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        return false;
+    }
+
+    // 在读取条目之前取修改时间，读取期间发生的变化会使之后看到的时间更新
+    // 目录中的普通文件与目录本身位于同一设备，其标识直接由d_ino和该设备号组成
+    struct stat dirStat;
+    const bool statted = fstat(dirFd, &dirStat) == 0;
+    const quint64 device = statted ? static_cast<quint64>(dirStat.st_dev) : 0;
+    if (modified) {
+        *modified = statted ? toMSecs(dirStat.st_mtim) : 0;
+    }
+    if (directoryId) {
+        *directoryId = statted ? FileId(device, static_cast<quint64>(dirStat.st_ino)) : FileId();
+    }
+
+    alignas(8) char buffer[DirentBufferSize];
+    while (true) {
+        const long bytes = syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer));
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes < 0) {
+            // 读取中途出错时目录内容不完整，与打开失败同样处理
+            close(dirFd);
+            return false;
+        }
+        if (bytes == 0) {
+            break;
+        }
+
+        for (long offset = 0; offset < bytes;) {
+            const LinuxDirent64 *dirent = reinterpret_cast<const LinuxDirent64 *>(buffer + offset);
+            offset += dirent->d_reclen;
+
+            // 跳过.、..以及隐藏条目，隐藏的忽略文件先记下来
+            const char *name = dirent->d_name;
+            if (name[0] == '.') {
+                if (ignoreFiles && dirent->d_type != DT_DIR) {
+                    const QString hiddenName = QString::fromUtf8(name, static_cast<int>(strlen(name)));
+                    if (IgnoreStack::isIgnoreFile(hiddenName)) {
+                        ignoreFiles->append(hiddenName);
+                    }
+                }
+                continue;
+            }
+
+            EntryType type;
+            FileId id(device, dirent->d_ino);
+            struct stat st;
+            bool resolved = false;
+            switch (dirent->d_type) {
+            case DT_DIR:
+                type = EntryType::Directory;
+                break;
+            case DT_REG:
+                type = EntryType::File;
+                break;
+            case DT_LNK:
+            case DT_UNKNOWN:
+                // 只有这两种情况需要额外的stat
+                if (!resolveEntryType(dirFd, name, type, id, st)) {
+                    continue;
+                }
+                resolved = true;
+                break;
+            default:
+                // 设备、管道、套接字等系统条目
+                continue;
+            }
+
+            if (!includeFiles && type != EntryType::Directory) {
+                continue;
+            }
+
+            Entry entry(QString::fromUtf8(name, static_cast<int>(strlen(name))), type, statted ? id : FileId());
+            if (fileMetadata && type == EntryType::File) {
+                // 相对目录描述符查询，内核不必重新解析整条路径；已经stat过的条目直接复用
+                struct statx stx;
+                if (resolved) {
+                    entry.size = static_cast<qint64>(st.st_size);
+                    entry.modified = toMSecs(st.st_mtim);
+                } else if (statx(dirFd, name, 0, STATX_SIZE | STATX_MTIME, &stx) == 0) {
+                    entry.size = static_cast<qint64>(stx.stx_size);
+                    entry.modified = static_cast<qint64>(stx.stx_mtime.tv_sec) * 1000 + stx.stx_mtime.tv_nsec / 1000000;
+                }
+            }
+            entries.append(entry);
+        }
+    }
+
+    close(dirFd);
+#else
+    QDir dir(path);
+    if (!dir.exists()) {
+        return false;
+    }
+    if (modified) {
+        *modified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+    }
+    // QDir不提供inode，其他平台上不做重复检测
+    if (directoryId) {
+        *directoryId = FileId();
+    }
+
+    // QDir不列出隐藏条目，忽略文件只有几个固定的名称，逐个检查
+    if (ignoreFiles) {
+        for (const QString &name : IgnoreStack::fileNames()) {
+            if (QFileInfo(dir.filePath(name)).isFile()) {
+                ignoreFiles->append(name);
+            }
+        }
+    }
+
+    const QDir::Filters filters = includeFiles ? (QDir::AllEntries | QDir::NoDotAndDotDot)
+                                               : (QDir::Dirs | QDir::NoDotAndDotDot);
+    const QFileInfoList infos = dir.entryInfoList(filters, QDir::NoSort);
+    entries.reserve(entries.size() + infos.size());
+    for (const QFileInfo &info : infos) {
+        Entry entry(info.fileName(), info.isDir() ? EntryType::Directory : EntryType::File);
+        if (fileMetadata && !info.isDir()) {
+            entry.size = info.size();
+            entry.modified = info.lastModified().toMSecsSinceEpoch();
+        }
+        entries.append(entry);
+    }
+#endif
+
+    sortEntries(entries);
+    return true;
+}
+
+bool DirectoryScanner::queryMetadata(const QString &path, Metadata &metadata)
+{
+#ifdef Q_OS_LINUX
+    const QByteArray encodedPath = QFile::encodeName(path);
+
+    // 只请求需要的字段，文件系统可以跳过其余属性
+    struct statx stx;
+    if (statx(AT_FDCWD, encodedPath.constData(), 0, STATX_SIZE | STATX_MTIME, &stx) != 0) {
+        return false;
+    }
+
+    metadata.size = static_cast<qint64>(stx.stx_size);
+    metadata.lastModified = QDateTime::fromMSecsSinceEpoch(
+        static_cast<qint64>(stx.stx_mtime.tv_sec) * 1000 + stx.stx_mtime.tv_nsec / 1000000);
+    return true;
+#else
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return false;
+    }
+
+    metadata.size = info.size();
+    metadata.lastModified = info.lastModified();
+    return true;
+#endif
+}
+
+void DirectoryScanner::sortEntries(QVector<Entry> &entries)
+{
+    // 与QDir::Name | QDir::IgnoreCase一致，仅大小写不同时再区分大小写，保证结果确定
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        const int result = a.name.compare(b.name, Qt::CaseInsensitive);
+        if (result != 0) {
+            return result < 0;
+        }
+        return a.name < b.name;
+    });
+}
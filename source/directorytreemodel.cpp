@@ -0,0 +1,987 @@
+#include "directorytreemodel.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QLocale>
+#include <QSet>
+#include <QStyle>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+// 每次fetchMore向视图公开的最大子节点数
+const int FetchBatchSize = 1000;
+// 废弃的节点或名称字节超过该数量且超过总量一半时整理数组
+const int CompactMinGarbage = 4096;
+// 修改时间列的显示格式
+const char *const ModifiedFormat = "yyyy-MM-dd HH:mm";
+}
+
+DirectoryTreeModel::DirectoryTreeModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , m_sortColumn(-1)
+    , m_sortOrder(Qt::AscendingOrder)
+    , m_scanning(false)
+    , m_lazyLoading(false)
+    , m_garbageNodes(0)
+    , m_garbageNameBytes(0)
+{
+}
+
+DirectoryTreeModel::~DirectoryTreeModel()
+{
+}
+
+void DirectoryTreeModel::resetRoot(const QString &rootName, const QString &rootPath)
+{
+    beginResetModel();
+
+    // 根节点固定为下标0
+    m_result.reset(rootPath, rootName);
+    m_fetched.clear();
+    m_childOrders.clear();
+    m_garbageNodes = 0;
+    m_garbageNameBytes = 0;
+
+    endResetModel();
+}
+
+void DirectoryTreeModel::loadNodes(const QString &rootPath, const Node *nodes, int count, const char *names, quint32 nameBytes)
+{
+    beginResetModel();
+
+    // 一次性整体复制，之后的增量更新不再触碰来源内存
+    m_result.nodes.resize(count);
+    std::memcpy(m_result.nodes.data(), nodes, static_cast<size_t>(count) * sizeof(Node));
+    m_result.names = QByteArray(names, static_cast<int>(nameBytes));
+    m_result.rollups.clear();
+    m_fetched.clear();
+    m_childOrders.clear();
+    m_garbageNodes = 0;
+    m_garbageNameBytes = 0;
+    m_result.rootPath = rootPath;
+
+    endResetModel();
+}
+
+void DirectoryTreeModel::exportNodes(QVector<Node> &nodes, QByteArray &names, QVector<int> &sourceNodes) const
+{
+    nodes.clear();
+    names.clear();
+    sourceNodes.clear();
+    if (m_result.nodes.isEmpty()) {
+        return;
+    }
+
+    // 按层序遍历：处理第i个节点时，它的子节点依次追加到末尾，自然保持连续
+    auto appendNode = [&](int source, int parent) {
+        Node node = m_result.nodes.at(source);
+        node.parent = parent;
+        node.firstChild = -1;
+        node.childCount = 0;
+        node.nameOffset = static_cast<quint32>(names.size());
+        names.append(m_result.names.constData() + m_result.nodes.at(source).nameOffset, m_result.nodes.at(source).nameLength);
+        nodes.append(node);
+        sourceNodes.append(source);
+    };
+
+    appendNode(0, -1);
+    for (int i = 0; i < sourceNodes.size(); ++i) {
+        const Node &source = m_result.nodes.at(sourceNodes.at(i));
+        if (source.childCount > 0) {
+            nodes[i].firstChild = static_cast<qint32>(nodes.size());
+            nodes[i].childCount = source.childCount;
+            for (int row = 0; row < source.childCount; ++row) {
+                appendNode(source.firstChild + row, i);
+            }
+        }
+    }
+}
+
+void DirectoryTreeModel::appendBatch(const NodeBatch &batch)
+{
+    if (m_result.nodes.isEmpty()) {
+        return;
+    }
+
+    // 新节点都是尚未公开的目录的子节点，追加本身不会改变视图中的行
+    const int oldCount = m_result.nodes.size();
+    m_result.names.append(batch.names);
+    m_result.nodes.append(batch.nodes);
+    if (!batch.rollups.isEmpty()) {
+        // 之前追加的目录（例如根节点）在其子树完成前统计未定
+        if (m_result.rollups.size() < oldCount) {
+            m_result.rollups.resize(oldCount, Rollup::unknown());
+        }
+        m_result.rollups.append(batch.rollups);
+    }
+
+    for (const Listing &listing : batch.listings) {
+        if (listing.directory < 0 || listing.directory >= m_result.nodes.size()) {
+            continue;
+        }
+
+        Node &dir = m_result.nodes[listing.directory];
+        dir.firstChild = listing.childCount > 0 ? listing.firstChild : -1;
+        dir.childCount = listing.childCount;
+        dir.flags |= ListedFlag;
+
+        // 用户已经展开了正在等待读取的目录，立即公开第一批子节点
+        if (m_fetched.contains(listing.directory)) {
+            QModelIndex dirIndex = indexForNode(listing.directory);
+            if (dirIndex.isValid()) {
+                fetchMore(dirIndex);
+            }
+        }
+    }
+
+    // 按统计排序时，子目录的统计确定后重新排列已展开的父目录
+    QSet<qint32> resorted;
+    const bool sortByRollup = m_sortColumn >= FileCountColumn;
+    for (const RollupUpdate &update : batch.completedRollups) {
+        setRollup(update.node, update.rollup);
+        if (sortByRollup && update.node > 0) {
+            const qint32 parent = m_result.nodes.at(update.node).parent;
+            if (m_childOrders.contains(parent)) {
+                resorted.insert(parent);
+            }
+        }
+    }
+    if (!resorted.isEmpty()) {
+        resortDirectories(resorted.values());
+    }
+}
+
+DirectoryTreeModel::ChildrenUpdate DirectoryTreeModel::replaceChildren(int directory, const QVector<Child> &children)
+{
+    ChildrenUpdate update;
+    if (directory < 0 || directory >= m_result.nodes.size() || !isDirectory(directory)) {
+        return update;
+    }
+
+    const bool wasListed = isListed(directory);
+    const int oldFirst = m_result.nodes.at(directory).firstChild;
+    const int oldCount = wasListed ? m_result.nodes.at(directory).childCount : 0;
+    const int oldFetched = fetchedCount(directory);
+    const bool expanded = m_fetched.contains(directory);
+    const QModelIndex dirIndex = indexForNode(directory);
+    const bool exposed = dirIndex.isValid();
+
+    // 旧子节点按名称索引，名称和类型都未变化的节点直接复用
+    QHash<QByteArray, int> oldChildren;
+    oldChildren.reserve(oldCount);
+    for (int i = 0; i < oldCount; ++i) {
+        const Node &n = m_result.nodes.at(oldFirst + i);
+        oldChildren.insert(QByteArray(m_result.names.constData() + n.nameOffset, n.nameLength), oldFirst + i);
+    }
+
+    QVector<QByteArray> utf8Names(children.size());
+    QVector<int> reusedFrom(children.size(), -1);
+    for (int i = 0; i < children.size(); ++i) {
+        utf8Names[i] = children.at(i).name.toUtf8();
+        auto it = oldChildren.find(utf8Names.at(i));
+        if (it != oldChildren.end() && isDirectory(it.value()) == children.at(i).isDir) {
+            reusedFrom[i] = it.value();
+            oldChildren.erase(it);
+        }
+    }
+
+    // 剩下的旧子节点已经消失
+    QSet<int> removed;
+    for (auto it = oldChildren.constBegin(); it != oldChildren.constEnd(); ++it) {
+        removed.insert(it.value());
+        if (isDirectory(it.value())) {
+            update.removedDirectories.append(QString::fromUtf8(it.key()));
+        }
+    }
+
+    // 第一步：在旧区间上删除消失的行，其余已公开的行保持原来的顺序
+    QVector<qint32> visible;
+    visible.reserve(oldFetched);
+    for (int row = 0; row < oldFetched; ++row) {
+        visible.append(childAtRow(directory, row) - oldFirst);
+    }
+    for (int last = visible.size() - 1; last >= 0; --last) {
+        if (!removed.contains(oldFirst + visible.at(last))) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && removed.contains(oldFirst + visible.at(first - 1))) {
+            --first;
+        }
+        if (exposed) {
+            beginRemoveRows(dirIndex, first, last);
+        }
+        visible.remove(first, last - first + 1);
+        setChildRows(directory, visible);
+        if (exposed) {
+            endRemoveRows();
+        }
+        last = first;
+    }
+
+    // 第二步：子节点移动到数组末尾的新区间，行数不变，只迁移持久索引指向的节点
+    if (exposed) {
+        emit layoutAboutToBeChanged();
+    }
+
+    // 新的子节点区间追加在数组末尾，保证同一目录的子节点连续存放
+    const int newFirst = m_result.nodes.size();
+    QHash<int, int> moved;
+    m_result.nodes.reserve(newFirst + children.size());
+    const bool rollups = hasRollups();
+    if (rollups) {
+        m_result.rollups.resize(newFirst, Rollup::unknown());
+    }
+    for (int i = 0; i < children.size(); ++i) {
+        const Child &child = children.at(i);
+        const int newNode = m_result.nodes.size();
+
+        if (reusedFrom.at(i) >= 0) {
+            const Node reused = m_result.nodes.at(reusedFrom.at(i));
+            m_result.nodes.append(reused);
+            if (rollups) {
+                m_result.rollups.append(m_result.rollup(reusedFrom.at(i)));
+            }
+            moved.insert(reusedFrom.at(i), newNode);
+            continue;
+        }
+
+        const QByteArray &utf8Name = utf8Names.at(i);
+        Node node;
+        node.parent = directory;
+        node.firstChild = -1;
+        node.childCount = 0;
+        node.nameOffset = static_cast<quint32>(m_result.names.size());
+        node.nameLength = static_cast<quint16>(utf8Name.size());
+        node.flags = child.isDir ? DirectoryFlag : 0;
+        node.reserved = 0;
+        m_result.names.append(utf8Name);
+        m_result.nodes.append(node);
+        if (rollups) {
+            // 新目录在读取之前按空目录计入，读取后再逐级更新
+            m_result.rollups.append(child.isDir ? Rollup::empty() : Rollup::file(child.size, child.modified));
+        }
+
+        if (child.isDir) {
+            update.addedDirectories.append(newNode);
+        }
+    }
+
+    // 被复用的目录的子节点改为指向新位置，展开记录随节点一起迁移
+    for (auto it = moved.constBegin(); it != moved.constEnd(); ++it) {
+        const Node &n = m_result.nodes.at(it.value());
+        for (int i = 0; i < n.childCount; ++i) {
+            m_result.nodes[n.firstChild + i].parent = it.value();
+        }
+        if (m_fetched.contains(it.key())) {
+            m_fetched.insert(it.value(), m_fetched.take(it.key()));
+        }
+        if (m_childOrders.contains(it.key())) {
+            m_childOrders.insert(it.value(), m_childOrders.take(it.key()));
+        }
+    }
+
+    // 旧区间和消失的子树不再被引用，累计后由compactNodes()统一回收
+    m_garbageNodes += oldCount;
+    QVector<int> stack(removed.cbegin(), removed.cend());
+    while (!stack.isEmpty()) {
+        const int node = stack.takeLast();
+        const Node &n = m_result.nodes.at(node);
+        m_garbageNameBytes += n.nameLength;
+        m_fetched.remove(node);
+        m_childOrders.remove(node);
+        for (int i = 0; i < n.childCount; ++i) {
+            stack.append(n.firstChild + i);
+        }
+        if (node < oldFirst || node >= oldFirst + oldCount) {
+            ++m_garbageNodes;
+        }
+    }
+
+    const int newCount = static_cast<int>(children.size());
+    Node &dir = m_result.nodes[directory];
+    dir.firstChild = newCount > 0 ? newFirst : -1;
+    dir.childCount = newCount;
+    dir.flags |= ListedFlag;
+
+    QVector<qint32> kept;
+    kept.reserve(visible.size());
+    for (qint32 offset : visible) {
+        kept.append(moved.value(oldFirst + offset) - newFirst);
+    }
+    if (expanded) {
+        setChildRows(directory, kept);
+    } else {
+        updateChildOrder(directory);
+    }
+
+    if (exposed) {
+        // 已公开的子节点行号不变，持久索引（视图的展开状态、选择等）改为指向新节点
+        const QModelIndexList persistent = persistentIndexList();
+        QModelIndexList from;
+        QModelIndexList to;
+        for (const QModelIndex &index : persistent) {
+            const auto it = moved.constFind(nodeFromIndex(index));
+            if (it != moved.constEnd()) {
+                from.append(index);
+                to.append(createIndex(index.row(), index.column(), quintptr(it.value())));
+            }
+        }
+        changePersistentIndexList(from, to);
+
+        emit layoutChanged();
+    }
+
+    if (expanded) {
+        // 第三步：已展开的目录至少保持原来公开的行数，原有的行都留在公开范围内，
+        // 新公开的行先排在原有行之后插入
+        updateChildOrder(directory);
+        QVector<qint32> finalRows(newCount);
+        const auto order = m_childOrders.constFind(directory);
+        if (order != m_childOrders.constEnd()) {
+            finalRows = order->rows;
+        } else {
+            std::iota(finalRows.begin(), finalRows.end(), 0);
+        }
+
+        int newFetched = qMin(newCount, qMax(oldFetched, FetchBatchSize));
+        QSet<qint32> keptOffsets;
+        for (qint32 offset : kept) {
+            keptOffsets.insert(offset);
+            const int row = order != m_childOrders.constEnd() ? order->positions.at(offset) : offset;
+            newFetched = qMax(newFetched, row + 1);
+        }
+
+        QVector<qint32> rows = kept;
+        for (int row = 0; row < newFetched; ++row) {
+            if (!keptOffsets.contains(finalRows.at(row))) {
+                rows.append(finalRows.at(row));
+            }
+        }
+        if (exposed && rows.size() > kept.size()) {
+            beginInsertRows(dirIndex, kept.size(), rows.size() - 1);
+            setChildRows(directory, rows);
+            endInsertRows();
+        } else {
+            setChildRows(directory, rows);
+        }
+
+        // 第四步：公开的行集合已与最终顺序一致，再按当前排序重排
+        if (exposed && rows != finalRows.mid(0, rows.size())) {
+            resortDirectories(QList<qint32>{directory});
+        } else {
+            updateChildOrder(directory);
+        }
+    }
+
+    if (rollups) {
+        recomputeRollups(directory);
+    }
+
+    // 扫描期间读取器按节点数量为新批次编号，不能重新编号
+    const bool tooMuchGarbage = m_garbageNodes > qMax<qint64>(CompactMinGarbage, m_result.nodes.size() / 2)
+                                || m_garbageNameBytes > qMax<qint64>(CompactMinGarbage, m_result.names.size() / 2);
+    if (tooMuchGarbage && !m_scanning) {
+        compactNodes(update.addedDirectories);
+    }
+    return update;
+}
+
+void DirectoryTreeModel::setChildRows(int node, const QVector<qint32> &visible)
+{
+    const int count = m_result.nodes.at(node).childCount;
+
+    // 公开的行在前，其余子节点按节点顺序排在后面
+    ChildOrder order;
+    order.rows = visible;
+    order.positions.fill(-1, count);
+    for (int row = 0; row < visible.size(); ++row) {
+        order.positions[visible.at(row)] = row;
+    }
+    for (int offset = 0; offset < count; ++offset) {
+        if (order.positions.at(offset) < 0) {
+            order.positions[offset] = order.rows.size();
+            order.rows.append(offset);
+        }
+    }
+
+    m_childOrders.insert(node, order);
+    m_fetched.insert(node, visible.size());
+}
+
+void DirectoryTreeModel::compactNodes(QVector<int> &nodes)
+{
+    QVector<Node> compacted;
+    QByteArray names;
+    QVector<int> sourceNodes;
+    exportNodes(compacted, names, sourceNodes);
+
+    QVector<qint32> remap(m_result.nodes.size(), -1);
+    for (int i = 0; i < sourceNodes.size(); ++i) {
+        remap[sourceNodes.at(i)] = i;
+    }
+
+    // 子节点按原有偏移顺序导出，行号和行映射都不变，只有节点下标变化
+    emit layoutAboutToBeChanged();
+
+    const QModelIndexList persistent = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) {
+        const int node = remap.at(nodeFromIndex(index));
+        to.append(node >= 0 ? createIndex(index.row(), index.column(), quintptr(node)) : QModelIndex());
+    }
+
+    if (hasRollups()) {
+        QVector<Rollup> rollups;
+        rollups.reserve(sourceNodes.size());
+        for (int source : sourceNodes) {
+            rollups.append(m_result.rollup(source));
+        }
+        m_result.rollups = rollups;
+    }
+
+    QHash<qint32, qint32> fetched;
+    for (auto it = m_fetched.constBegin(); it != m_fetched.constEnd(); ++it) {
+        if (remap.at(it.key()) >= 0) {
+            fetched.insert(remap.at(it.key()), it.value());
+        }
+    }
+    QHash<qint32, ChildOrder> childOrders;
+    for (auto it = m_childOrders.constBegin(); it != m_childOrders.constEnd(); ++it) {
+        if (remap.at(it.key()) >= 0) {
+            childOrders.insert(remap.at(it.key()), it.value());
+        }
+    }
+
+    m_result.nodes = compacted;
+    m_result.names = names;
+    m_fetched = fetched;
+    m_childOrders = childOrders;
+    m_garbageNodes = 0;
+    m_garbageNameBytes = 0;
+    for (int &node : nodes) {
+        node = remap.at(node);
+    }
+
+    changePersistentIndexList(persistent, to);
+    emit layoutChanged();
+}
+
+int DirectoryTreeModel::findNode(const QString &path) const
+{
+    if (m_result.nodes.isEmpty()) {
+        return -1;
+    }
+
+    QString rootPrefix = m_result.rootPath;
+    if (!rootPrefix.endsWith('/')) {
+        rootPrefix += '/';
+    }
+    if (path == m_result.rootPath || path == rootPrefix) {
+        return 0;
+    }
+    if (!path.startsWith(rootPrefix)) {
+        return -1;
+    }
+
+    // 逐级在子节点中按名称查找
+    int node = 0;
+    const QStringList parts = path.mid(rootPrefix.size()).split('/', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        const QByteArray utf8Name = part.toUtf8();
+        const Node &n = m_result.nodes.at(node);
+
+        int found = -1;
+        for (int i = 0; i < n.childCount; ++i) {
+            if (nameEquals(n.firstChild + i, utf8Name)) {
+                found = n.firstChild + i;
+                break;
+            }
+        }
+        if (found < 0) {
+            return -1;
+        }
+        node = found;
+    }
+
+    return node;
+}
+
+int DirectoryTreeModel::nodeDepth(int node) const
+{
+    if (node < 0 || node >= m_result.nodes.size()) {
+        return -1;
+    }
+
+    int depth = 0;
+    for (int current = node; current > 0; current = m_result.nodes.at(current).parent) {
+        ++depth;
+    }
+    return depth;
+}
+
+bool DirectoryTreeModel::isListed(int node) const
+{
+    if (node < 0 || node >= m_result.nodes.size()) {
+        return false;
+    }
+    return (m_result.nodes.at(node).flags & ListedFlag) != 0;
+}
+
+void DirectoryTreeModel::setScanning(bool scanning)
+{
+    if (m_scanning == scanning) {
+        return;
+    }
+
+    // 扫描结束后未读取的目录不再显示展开标记，需要视图重新布局
+    emit layoutAboutToBeChanged();
+    m_scanning = scanning;
+    emit layoutChanged();
+}
+
+void DirectoryTreeModel::setLazyLoading(bool lazy)
+{
+    if (m_lazyLoading == lazy) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+    m_lazyLoading = lazy;
+    emit layoutChanged();
+}
+
+bool DirectoryTreeModel::isFetched(int node) const
+{
+    return m_fetched.contains(node);
+}
+
+bool DirectoryTreeModel::hasRollups() const
+{
+    return !m_result.rollups.isEmpty();
+}
+
+const ScanResult &DirectoryTreeModel::scanResult() const
+{
+    return m_result;
+}
+
+int DirectoryTreeModel::nodeCount() const
+{
+    return m_result.nodes.size();
+}
+
+quint32 DirectoryTreeModel::nameBytes() const
+{
+    return static_cast<quint32>(m_result.names.size());
+}
+
+QString DirectoryTreeModel::nodeName(int node) const
+{
+    return m_result.name(node);
+}
+
+QByteArray DirectoryTreeModel::nodeNameUtf8(int node) const
+{
+    return m_result.nameUtf8(node);
+}
+
+bool DirectoryTreeModel::isDirectory(int node) const
+{
+    return m_result.isDirectory(node);
+}
+
+int DirectoryTreeModel::childCount(int node) const
+{
+    if (node < 0 || node >= m_result.nodes.size()) {
+        return 0;
+    }
+    return m_result.nodes.at(node).childCount;
+}
+
+int DirectoryTreeModel::child(int node, int row) const
+{
+    if (row < 0 || row >= childCount(node)) {
+        return -1;
+    }
+    return m_result.nodes.at(node).firstChild + row;
+}
+
+QString DirectoryTreeModel::filePath(int node) const
+{
+    return m_result.filePath(node);
+}
+
+int DirectoryTreeModel::nodeFromIndex(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return -1;
+    }
+    return static_cast<int>(index.internalId());
+}
+
+QModelIndex DirectoryTreeModel::indexForNode(int node, int column) const
+{
+    if (node < 0 || node >= m_result.nodes.size()) {
+        return QModelIndex();
+    }
+    if (node == 0) {
+        return createIndex(0, column, quintptr(0));
+    }
+
+    const int parentNode = m_result.nodes.at(node).parent;
+    int row = node - m_result.nodes.at(parentNode).firstChild;
+    const auto order = m_childOrders.constFind(parentNode);
+    if (order != m_childOrders.constEnd()) {
+        row = order->positions.at(row);
+    }
+    if (row >= fetchedCount(parentNode)) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, quintptr(node));
+}
+
+int DirectoryTreeModel::fetchedCount(int node) const
+{
+    return m_fetched.value(node, 0);
+}
+
+int DirectoryTreeModel::childAtRow(int node, int row) const
+{
+    const auto order = m_childOrders.constFind(node);
+    const int offset = order != m_childOrders.constEnd() ? order->rows.at(row) : row;
+    return m_result.nodes.at(node).firstChild + offset;
+}
+
+bool DirectoryTreeModel::isNaturalOrder() const
+{
+    // 子节点按名称升序存放，名称和路径升序时行号就是节点顺序
+    return m_sortColumn < 0
+           || ((m_sortColumn == NameColumn || m_sortColumn == PathColumn) && m_sortOrder == Qt::AscendingOrder);
+}
+
+void DirectoryTreeModel::updateChildOrder(int node)
+{
+    const Node &n = m_result.nodes.at(node);
+    if (isNaturalOrder() || !(n.flags & ListedFlag) || n.childCount < 2) {
+        m_childOrders.remove(node);
+        return;
+    }
+
+    // 先取出每个子节点的整数键，排序时不再格式化或比较字符串；
+    // 统计未定的目录排在最小的一端
+    QVector<qint64> keys(n.childCount);
+    for (int i = 0; i < n.childCount; ++i) {
+        const int child = n.firstChild + i;
+        const Rollup rollup = m_result.rollup(child);
+        switch (m_sortColumn) {
+        case TypeColumn:
+            keys[i] = isDirectory(child) ? 0 : 1;
+            break;
+        case FileCountColumn:
+            keys[i] = isDirectory(child) ? rollup.files : 0;
+            break;
+        case SizeColumn:
+            keys[i] = rollup.isKnown() ? rollup.bytes : -1;
+            break;
+        case ModifiedColumn:
+            keys[i] = rollup.isKnown() ? rollup.modified : -1;
+            break;
+        default:
+            keys[i] = i;
+            break;
+        }
+    }
+
+    // 稳定排序，键相同的子节点保持名称顺序
+    ChildOrder order;
+    order.rows.resize(n.childCount);
+    std::iota(order.rows.begin(), order.rows.end(), 0);
+    const bool descending = (m_sortOrder == Qt::DescendingOrder);
+    std::stable_sort(order.rows.begin(), order.rows.end(), [&keys, descending](qint32 a, qint32 b) {
+        return descending ? keys.at(b) < keys.at(a) : keys.at(a) < keys.at(b);
+    });
+
+    order.positions.resize(n.childCount);
+    for (int row = 0; row < n.childCount; ++row) {
+        order.positions[order.rows.at(row)] = row;
+    }
+    m_childOrders.insert(node, order);
+}
+
+void DirectoryTreeModel::resortDirectories(const QList<qint32> &directories)
+{
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    for (qint32 directory : directories) {
+        updateChildOrder(directory);
+    }
+
+    // 节点下标不变，只有行号变化；排到已公开范围之外的节点失去索引
+    const QModelIndexList persistent = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) {
+        to.append(indexForNode(nodeFromIndex(index), index.column()));
+    }
+    changePersistentIndexList(persistent, to);
+
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+void DirectoryTreeModel::setRollup(int node, const Rollup &rollup)
+{
+    if (node < 0 || node >= m_result.rollups.size()) {
+        return;
+    }
+
+    m_result.rollups[node] = rollup;
+    const QModelIndex first = indexForNode(node, FileCountColumn);
+    if (first.isValid()) {
+        emit dataChanged(first, indexForNode(node, ModifiedColumn));
+    }
+}
+
+void DirectoryTreeModel::recomputeRollups(int directory)
+{
+    // 每一级只合计直接子节点，代价与路径上各目录的子节点数成正比
+    for (int node = directory; node >= 0; node = m_result.nodes.at(node).parent) {
+        const Node &n = m_result.nodes.at(node);
+        Rollup total = Rollup::empty();
+        for (int i = 0; i < n.childCount; ++i) {
+            const Rollup child = m_result.rollup(n.firstChild + i);
+            if (!child.isKnown()) {
+                total = Rollup::unknown();
+                break;
+            }
+            total.add(child);
+        }
+        setRollup(node, total);
+    }
+}
+
+bool DirectoryTreeModel::nameEquals(int node, const QByteArray &utf8Name) const
+{
+    const Node &n = m_result.nodes.at(node);
+    return n.nameLength == utf8Name.size()
+           && std::memcmp(m_result.names.constData() + n.nameOffset, utf8Name.constData(), n.nameLength) == 0;
+}
+
+QModelIndex DirectoryTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+
+    // 顶层只有根节点
+    if (!parent.isValid()) {
+        return createIndex(row, column, quintptr(0));
+    }
+
+    return createIndex(row, column, quintptr(childAtRow(nodeFromIndex(parent), row)));
+}
+
+QModelIndex DirectoryTreeModel::parent(const QModelIndex &index) const
+{
+    const int node = nodeFromIndex(index);
+    if (node <= 0) {
+        return QModelIndex();
+    }
+    return indexForNode(m_result.nodes.at(node).parent);
+}
+
+int DirectoryTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return m_result.nodes.isEmpty() ? 0 : 1;
+    }
+    if (parent.column() > 0) {
+        return 0;
+    }
+    return fetchedCount(nodeFromIndex(parent));
+}
+
+int DirectoryTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return ColumnCount;
+}
+
+bool DirectoryTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return !m_result.nodes.isEmpty();
+    }
+    if (parent.column() > 0) {
+        return false;
+    }
+
+    const Node &n = m_result.nodes.at(nodeFromIndex(parent));
+    if (n.childCount > 0) {
+        return true;
+    }
+
+    // 扫描期间或按需读取模式下，尚未读取的目录先显示展开标记
+    return (m_scanning || m_lazyLoading) && (n.flags & DirectoryFlag) && !(n.flags & ListedFlag);
+}
+
+QVariant DirectoryTreeModel::data(const QModelIndex &index, int role) const
+{
+    const int node = nodeFromIndex(index);
+    if (node < 0 || node >= m_result.nodes.size()) {
+        return QVariant();
+    }
+
+    const bool isDir = (m_result.nodes.at(node).flags & DirectoryFlag) != 0;
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case NameColumn:
+            return nodeName(node);
+        case TypeColumn:
+            return isDir ? QStringLiteral("目录") : QStringLiteral("文件");
+        case PathColumn:
+            return filePath(node);
+        case FileCountColumn:
+        case SizeColumn:
+        case ModifiedColumn: {
+            // 子树尚未读取完成的目录暂不显示
+            const Rollup rollup = m_result.rollup(node);
+            if (!rollup.isKnown()) {
+                break;
+            }
+            if (index.column() == FileCountColumn) {
+                return isDir ? QVariant(QLocale().toString(rollup.files)) : QVariant();
+            }
+            if (index.column() == SizeColumn) {
+                return QLocale().formattedDataSize(rollup.bytes);
+            }
+            return rollup.modified > 0 ? QVariant(QDateTime::fromMSecsSinceEpoch(rollup.modified).toString(ModifiedFormat))
+                                       : QVariant();
+        }
+        default:
+            break;
+        }
+    } else if (role == Qt::TextAlignmentRole
+               && (index.column() == FileCountColumn || index.column() == SizeColumn)) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    } else if (role == Qt::DecorationRole && index.column() == NameColumn) {
+        // 图标只创建一次，所有节点共享
+        if (m_dirIcon.isNull()) {
+            m_dirIcon = QApplication::style()->standardIcon(QStyle::SP_DirIcon);
+            m_fileIcon = QApplication::style()->standardIcon(QStyle::SP_FileIcon);
+        }
+        return isDir ? m_dirIcon : m_fileIcon;
+    }
+
+    return QVariant();
+}
+
+QVariant DirectoryTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case NameColumn:
+        return QStringLiteral("名称");
+    case TypeColumn:
+        return QStringLiteral("类型");
+    case PathColumn:
+        return QStringLiteral("路径");
+    case FileCountColumn:
+        return QStringLiteral("文件数");
+    case SizeColumn:
+        return QStringLiteral("大小");
+    case ModifiedColumn:
+        return QStringLiteral("修改时间");
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags DirectoryTreeModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+bool DirectoryTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    const int node = nodeFromIndex(parent);
+    if (node < 0 || parent.column() > 0) {
+        return false;
+    }
+
+    const Node &n = m_result.nodes.at(node);
+    if (!(n.flags & DirectoryFlag)) {
+        return false;
+    }
+
+    // 尚未读取的目录也允许fetchMore，用于记录用户已展开该目录
+    if (!(n.flags & ListedFlag)) {
+        return (m_scanning || m_lazyLoading) && !m_fetched.contains(node);
+    }
+    return fetchedCount(node) < n.childCount;
+}
+
+void DirectoryTreeModel::fetchMore(const QModelIndex &parent)
+{
+    const int node = nodeFromIndex(parent);
+    if (node < 0 || parent.column() > 0) {
+        return;
+    }
+
+    const Node &n = m_result.nodes.at(node);
+    const int fetched = fetchedCount(node);
+
+    // 目录还没有读取完成，先记下展开请求，等子节点到达后再公开
+    if (!(n.flags & ListedFlag)) {
+        m_fetched.insert(node, fetched);
+        if (m_lazyLoading) {
+            emit listingRequested(node);
+        }
+        return;
+    }
+
+    const int remaining = n.childCount - fetched;
+    if (remaining <= 0) {
+        m_fetched.insert(node, fetched);
+        return;
+    }
+
+    // 第一次公开时按当前排序生成行映射，之后的批次沿用同一顺序
+    if (fetched == 0) {
+        updateChildOrder(node);
+    }
+
+    const int count = qMin(remaining, FetchBatchSize);
+    beginInsertRows(parent, fetched, fetched + count - 1);
+    m_fetched.insert(node, fetched + count);
+    endInsertRows();
+}
+
+void DirectoryTreeModel::sort(int column, Qt::SortOrder order)
+{
+    // 超出范围的列（例如视图取消排序时的-1）恢复为节点顺序
+    if (column < 0 || column >= ColumnCount) {
+        column = -1;
+    }
+    if (column == m_sortColumn && order == m_sortOrder) {
+        return;
+    }
+
+    m_sortColumn = column;
+    m_sortOrder = order;
+
+    // 只有已展开的目录公开了行；其余目录在第一次展开时按新的排序生成行映射
+    resortDirectories(m_fetched.keys());
+}
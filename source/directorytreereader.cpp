@@ -1,38 +1,90 @@
 #include "directorytreereader.h"
+#include "directoryscanner.h"
+#include "filemetadatacollector.h"
+#include "filtermatcher.h"
+#include "filtertrace.h"
+#include "scansnapshot.h"
 
 #include <QtConcurrent/QtConcurrent>
 #include <QRegularExpression>
 #include <QDebug>
 #include <QStyle>
 #include <QApplication>
-#include <filesystem>
+#include <QCryptographicHash>
+#include <deque>
+#include <vector>
 
-namespace fs = std::filesystem;
+namespace {
+// 单个批次最多包含的节点数，以及批次之间的最长间隔（毫秒）
+const int NodeBatchSize = 4096;
+const qint64 NodeBatchInterval = 100;
+// 增量更新后写入快照前的等待时间（毫秒），连续的更新只写一次
+const int SnapshotSaveDelay = 5000;
+// 每个后台任务最多读取的目录数，新的展开请求最多等待一个任务
+const int RefreshBatchSize = 32;
+// 流式输出文本表示时每次写入设备的字节数
+const int TextChunkSize = 64 * 1024;
+// 预留给条目名的长度，常见文件系统的名称不超过255字节，UTF-16长度不会更长
+const int MaxNameLength = 256;
+// "    "与"│   "的UTF-8字节数，回溯时按此长度截短行前缀
+const int BlankIndentBytes = 4;
+const int BranchIndentBytes = 6;
+}
 
 DirectoryTreeReader::DirectoryTreeReader(QObject *parent)
     : QObject(parent)
-    , treeWidget(nullptr)
+    , treeModel(new DirectoryTreeModel(this))
     , maxDepth(3)
+    , scanOrder(DirectoryWalker::Order::BreadthFirst)
     , readFiles(true)
+    , deduplicateHardLinks(false)
+    , computeRollups(false)
+    , ignoreFilesEnabled(true)
+    , exporter(nullptr)
     , isCancelled(false)
+    , scanGeneration(0)
+    , nextNodeId(0)
+    , nextNameOffset(0)
+    , directoryWatcher(new DirectoryWatcher(this))
+    , watchEnabled(false)
+    , lazyLoading(false)
+    , refreshRunning(false)
+    , snapshotEnabled(true)
+    , filterRootLength(0)
+    , snapshotTimer(new QTimer(this))
+    , progressTracker(new ProgressTracker(ProgressTracker::Unit::Directories, this))
 {
     // 初始化FutureWatcher并连接信号
     watcher = new QFutureWatcher<void>(this);
     connect(watcher, &QFutureWatcher<void>::finished, this, &DirectoryTreeReader::onReadingFinished);
+    
+    // 目录变化只重新读取受影响的目录
+    connect(directoryWatcher, &DirectoryWatcher::directoriesChanged, this, &DirectoryTreeReader::refreshDirectories);
+    connect(directoryWatcher, &DirectoryWatcher::rescanRequired, this, &DirectoryTreeReader::refreshAllDirectories);
+    connect(treeModel, &DirectoryTreeModel::listingRequested, this, &DirectoryTreeReader::requestListing);
+    
+    snapshotTimer->setSingleShot(true);
+    snapshotTimer->setInterval(SnapshotSaveDelay);
+    connect(snapshotTimer, &QTimer::timeout, this, &DirectoryTreeReader::saveSnapshot);
+    
+    connect(progressTracker, &ProgressTracker::progressUpdated, this, &DirectoryTreeReader::progressUpdated);
 }
 
 DirectoryTreeReader::~DirectoryTreeReader()
 {
     // 确保取消任何正在运行的任务
+    isCancelled = true;
     if (watcher->isRunning()) {
-        isCancelled = true;
         watcher->waitForFinished();
     }
+    refreshFuture.waitForFinished();
+    revalidateFuture.waitForFinished();
+    snapshotFuture.waitForFinished();
 }
 
-void DirectoryTreeReader::setTreeWidget(QTreeWidget *treeWidget)
+DirectoryTreeModel *DirectoryTreeReader::model() const
 {
-    this->treeWidget = treeWidget;
+    return treeModel;
 }
 
 void DirectoryTreeReader::setMaxDepth(int depth)
@@ -45,6 +97,31 @@ void DirectoryTreeReader::setReadFiles(bool readFiles)
     this->readFiles = readFiles;
 }
 
+void DirectoryTreeReader::setScanOrder(DirectoryWalker::Order order)
+{
+    scanOrder = order;
+}
+
+void DirectoryTreeReader::setDeduplicateHardLinks(bool enabled)
+{
+    deduplicateHardLinks = enabled;
+}
+
+void DirectoryTreeReader::setComputeRollups(bool enabled)
+{
+    computeRollups = enabled;
+}
+
+void DirectoryTreeReader::setIgnoreFilesEnabled(bool enabled)
+{
+    ignoreFilesEnabled = enabled;
+}
+
+void DirectoryTreeReader::setExporter(ScanExporter *exporter)
+{
+    this->exporter = exporter;
+}
+
 void DirectoryTreeReader::setFilterRules(const QList<FileFilterUtil::FilterRule> &rules)
 {
     fileFilter.setFilterRules(rules);
@@ -55,9 +132,55 @@ QList<FileFilterUtil::FilterRule> DirectoryTreeReader::getFilterRules() const
     return fileFilter.getFilterRules();
 }
 
+QVector<FileFilterUtil::RuleStatistics> DirectoryTreeReader::ruleStatistics() const
+{
+    return fileFilter.ruleStatistics();
+}
+
+void DirectoryTreeReader::setWatchEnabled(bool enabled)
+{
+    watchEnabled = enabled;
+    
+    if (!enabled) {
+        directoryWatcher->clear();
+        if (!lazyLoading) {
+            pendingRefreshPaths.clear();
+        }
+        return;
+    }
+    
+    // 已有读取完成的目录树时立即开始监视，否则在读取完成后开始
+    if (!watcher->isRunning() && treeModel->nodeCount() > 0) {
+        startWatching();
+    }
+}
+
+bool DirectoryTreeReader::isWatchEnabled() const
+{
+    return watchEnabled;
+}
+
+void DirectoryTreeReader::setLazyLoading(bool enabled)
+{
+    lazyLoading = enabled;
+    treeModel->setLazyLoading(enabled);
+}
+
+bool DirectoryTreeReader::isLazyLoading() const
+{
+    return lazyLoading;
+}
+
+void DirectoryTreeReader::setSnapshotEnabled(bool enabled)
+{
+    snapshotEnabled = enabled;
+}
+
 void DirectoryTreeReader::read(const QString &rootPath)
 {
-    if (!treeWidget) {
+    // 有可用的快照时直接显示，变化由后台校验补上；导出时总是完整读取
+    if (!exporter && loadSnapshot(rootPath)) {
+        QMetaObject::invokeMethod(this, &DirectoryTreeReader::readingFinished, Qt::QueuedConnection);
         return;
     }
     
@@ -67,21 +190,66 @@ void DirectoryTreeReader::read(const QString &rootPath)
         watcher->waitForFinished();
     }
     
-    // 重置状态
+    // 重置状态，旧目录树的监视和未完成的重新读取全部作废
     isCancelled = false;
-    treeWidget->clear();
+    ++scanGeneration;
+    currentRootPath = rootPath;
+    const QString filterRoot = FileFilterUtil::normalizePath(rootPath, FileFilterUtil::EntryKind::Directory);
+    filterRootLength = filterRoot.size();
+    ignoreStacks.reset(filterRoot, true);
+    directoryWatcher->clear();
+    pendingRefreshPaths.clear();
+    snapshotTimer->stop();
+    {
+        QMutexLocker locker(&mtimeMutex);
+        directoryMtimes.clear();
+    }
     
-    // 创建根项
+    // 重置模型，根节点下标固定为0
     QDir rootDir(rootPath);
-    rootItem = new QTreeWidgetItem(QStringList() << rootDir.dirName() << "目录" << rootPath);
-    rootItem->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_DirIcon));
+    treeModel->resetRoot(rootDir.dirName(), rootPath);
+    treeModel->setScanning(true);
+    nextNodeId = treeModel->nodeCount();
+    nextNameOffset = treeModel->nameBytes();
+    pendingBatch = DirectoryTreeModel::NodeBatch();
+    pendingRollups.clear();
     
-    // 添加根项
-    treeWidget->addTopLevelItem(rootItem);
+    // 根目录是第一个已发现的目录
+    progressTracker->start();
+    progressTracker->addTotal(1);
     
-    // 在后台线程中执行目录读取操作
-    QFuture<void> future = QtConcurrent::run([this, rootPath]() {
-        this->readDirectory(rootPath, rootItem, 1);
+    // 在后台线程中执行目录读取操作，工作线程只构建节点，不直接接触模型
+    // 目录由并行遍历器读取，这里按确定的深度优先顺序组装节点
+    // 嵌套JSON只能按深度优先顺序边读边写
+    const DirectoryWalker::Order order = (exporter && exporter->requiresDepthFirst())
+                                             ? DirectoryWalker::Order::DepthFirst : scanOrder;
+    QFuture<void> future = QtConcurrent::run([this, rootPath, order]() {
+        // 符号链接环和绑定挂载会让同一目录出现在多条路径上，工作线程只报告目录标识，
+        // 由遍历器按组装顺序判定重复，每个目录只保留第一次出现的路径
+        DirectoryWalker walker(
+            [this](const QString &path, int, quint8 context, QVector<DirectoryWalker::Entry> &entries,
+                   DirectoryScanner::FileId &directoryId) {
+                listDirectory(path, static_cast<FileFilterUtil::DirectoryVerdict>(context), entries, &directoryId);
+            },
+            [this]() { return isCancelled; });
+        walker.setMaxDepth(maxDepth);
+        walker.setOrder(order);
+        walker.setDeduplicateFiles(deduplicateHardLinks);
+        
+        if (exporter) {
+            exporter->begin(rootPath);
+        }
+        this->batchTimer.start();
+        const int rootSlot = walker.start(rootPath, 1);
+        if (order == DirectoryWalker::Order::BreadthFirst) {
+            this->readBreadthFirst(walker, rootSlot, rootPath);
+        } else {
+            this->readDirectory(walker, rootSlot, 0, rootPath);
+        }
+        this->flushPendingNodes(true);
+        if (exporter) {
+            exporter->finish();
+        }
     });
     
     // 设置FutureWatcher以监视异步操作
@@ -91,232 +259,676 @@ void DirectoryTreeReader::read(const QString &rootPath)
 void DirectoryTreeReader::cancel()
 {
     isCancelled = true;
+    progressTracker->finish();
 }
 
 void DirectoryTreeReader::onReadingFinished()
 {
+    progressTracker->finish();
+    treeModel->setScanning(false);
+    exporter = nullptr;
+    
+    if (!isCancelled) {
+        saveSnapshot();
+    }
+    
+    if (watchEnabled) {
+        startWatching();
+    }
+    
+    // 读取期间展开的深层目录
+    if (!isCancelled && !pendingRefreshPaths.isEmpty() && !refreshRunning) {
+        startNextRefresh();
+    }
+    
     // 读取完成后发送信号
     emit readingFinished();
 }
 
-QString DirectoryTreeReader::generateTextRepresentation()
+QString DirectoryTreeReader::generateTextRepresentation(const QModelIndex &index)
 {
-    if (!treeWidget || treeWidget->topLevelItemCount() == 0) {
+    if (treeModel->nodeCount() == 0) {
         return QString();
     }
     
-    return generateTextRepresentation(treeWidget->topLevelItem(0));
+    const int node = treeModel->nodeFromIndex(index);
+    QByteArray buffer;
+    renderText(node < 0 ? 0 : node, buffer, nullptr);
+    return QString::fromUtf8(buffer);
 }
 
-void DirectoryTreeReader::readDirectory(const QString &path, QTreeWidgetItem *parent, int currentDepth)
+bool DirectoryTreeReader::writeTextRepresentation(QIODevice *device, const QModelIndex &index)
 {
-    if (isCancelled || currentDepth > maxDepth) {
-        return;
+    if (!device || treeModel->nodeCount() == 0) {
+        return false;
     }
+    
+    const int node = treeModel->nodeFromIndex(index);
+    QByteArray buffer;
+    buffer.reserve(TextChunkSize + 4096);
+    if (!renderText(node < 0 ? 0 : node, buffer, device)) {
+        return false;
+    }
+    return buffer.isEmpty() || device->write(buffer) == buffer.size();
+}
 
-    QDir dir(path);
-    QFileInfoList entries;
+bool DirectoryTreeReader::loadSnapshot(const QString &rootPath)
+{
+    // 快照中没有统计信息
+    if (!snapshotEnabled || computeRollups) {
+        return false;
+    }
+    
+    ScanSnapshot snapshot;
+    if (!snapshot.open(ScanSnapshot::snapshotFilePath(snapshotKey(rootPath))) || snapshot.rootPath() != rootPath) {
+        return false;
+    }
     
-    // 根据用户选择决定是否读取文件
-    if (readFiles) {
-        entries = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
-    } else {
-        entries = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    if (watcher->isRunning()) {
+        isCancelled = true;
+        watcher->waitForFinished();
     }
     
-    int total = entries.size();
-    int processed = 0;
-    int excluded = 0;
+    isCancelled = false;
+    ++scanGeneration;
+    currentRootPath = rootPath;
+    // 快照中的目录没有被进入过，重新读取时从文件系统补上祖先目录的忽略文件
+    const QString filterRoot = FileFilterUtil::normalizePath(rootPath, FileFilterUtil::EntryKind::Directory);
+    filterRootLength = filterRoot.size();
+    ignoreStacks.reset(filterRoot, false);
+    directoryWatcher->clear();
+    pendingRefreshPaths.clear();
+    snapshotTimer->stop();
     
-    // 检查是否有文件类型包含规则
-    bool hasFileTypeIncludeRule = false;
-    for (const FileFilterUtil::FilterRule &rule : fileFilter.getFilterRules()) {
-        if (!rule.enabled || rule.filterMode != FileFilterUtil::FilterMode::Include) continue;
-        
-        if (rule.pattern.startsWith("*.") || 
-            (rule.pattern.contains('.') && !rule.pattern.contains('/') && !rule.pattern.contains('\\'))) {
-            hasFileTypeIncludeRule = true;
-            break;
+    treeModel->loadNodes(rootPath, snapshot.nodes(), snapshot.nodeCount(), snapshot.names(), snapshot.nameBytes());
+    treeModel->setScanning(false);
+    
+    // 记录快照中的目录修改时间，作为校验和下次写入快照的基准
+    QStringList paths;
+    QVector<qint64> mtimes;
+    paths.reserve(snapshot.directoryTimeCount());
+    mtimes.reserve(snapshot.directoryTimeCount());
+    {
+        QMutexLocker locker(&mtimeMutex);
+        directoryMtimes.clear();
+        for (int i = 0; i < snapshot.directoryTimeCount(); ++i) {
+            const ScanSnapshot::DirectoryTime &time = snapshot.directoryTimes()[i];
+            const QString path = treeModel->filePath(time.node);
+            directoryMtimes.insert(path, time.modified);
+            paths.append(path);
+            mtimes.append(time.modified);
         }
     }
     
-    // 允许build目录自动排除的标志
-    bool allowBuildExclusion = true;
+    if (watchEnabled) {
+        startWatching();
+    }
+    revalidate(paths, mtimes);
+    return true;
+}
+
+void DirectoryTreeReader::saveSnapshot()
+{
+    if (!snapshotEnabled || computeRollups || isCancelled || treeModel->nodeCount() == 0) {
+        return;
+    }
+    
+    // 在主线程导出紧凑副本，写文件放到后台
+    QVector<DirectoryTreeModel::Node> nodes;
+    QByteArray names;
+    QVector<int> sourceNodes;
+    treeModel->exportNodes(nodes, names, sourceNodes);
+    
+    QVector<ScanSnapshot::DirectoryTime> directoryTimes;
+    {
+        QMutexLocker locker(&mtimeMutex);
+        for (int i = 0; i < nodes.size(); ++i) {
+            if (!(nodes.at(i).flags & DirectoryTreeModel::ListedFlag)) {
+                continue;
+            }
+            // 没有记录的目录按0处理，下次打开时一定会被重新读取
+            const qint64 modified = directoryMtimes.value(treeModel->filePath(sourceNodes.at(i)), 0);
+            directoryTimes.append(ScanSnapshot::DirectoryTime{i, 0, modified});
+        }
+    }
     
-    // 检查是否有明确包含build目录的规则
+    const QString filePath = ScanSnapshot::snapshotFilePath(snapshotKey(currentRootPath));
+    const QString rootPath = currentRootPath;
+    snapshotFuture.waitForFinished();
+    snapshotFuture = QtConcurrent::run([filePath, rootPath, nodes, names, directoryTimes]() {
+        if (!ScanSnapshot::write(filePath, rootPath, nodes, names, directoryTimes)) {
+            qWarning() << "无法写入扫描快照:" << filePath;
+        }
+    });
+}
+
+QByteArray DirectoryTreeReader::snapshotKey(const QString &rootPath) const
+{
+    // 影响扫描结果的所有参数都参与计算，参数不同的扫描使用不同的快照
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(rootPath.toUtf8());
+    hash.addData(QByteArray::number(maxDepth));
+    hash.addData(readFiles ? "1" : "0");
+    hash.addData(lazyLoading ? "1" : "0");
+    hash.addData(deduplicateHardLinks ? "1" : "0");
+    hash.addData(ignoreFilesEnabled ? "1" : "0");
     for (const FileFilterUtil::FilterRule &rule : fileFilter.getFilterRules()) {
-        if (!rule.enabled) continue;
+        hash.addData("\n");
+        hash.addData(rule.pattern.toUtf8());
+        hash.addData(QByteArray::number(static_cast<int>(rule.matchType)));
+        hash.addData(QByteArray::number(static_cast<int>(rule.filterMode)));
+        hash.addData(rule.enabled ? "1" : "0");
+    }
+    return hash.result().toHex();
+}
+
+void DirectoryTreeReader::revalidate(const QStringList &paths, const QVector<qint64> &mtimes)
+{
+    const int generation = scanGeneration;
+    revalidateFuture = QtConcurrent::run([this, generation, paths, mtimes]() {
+        // 目录的修改时间只在条目增删或改名时变化，时间一致说明内容与快照相同
+        QVector<DirectoryScanner::Metadata> metadata;
+        const QVector<bool> ok = FileMetadataCollector::collect(paths, metadata);
         
-        if (rule.filterMode == FileFilterUtil::FilterMode::Include) {
-            if (rule.pattern.contains("build", Qt::CaseInsensitive)) {
-                allowBuildExclusion = false;
-                break;
+        QStringList changed;
+        for (int i = 0; i < paths.size(); ++i) {
+            if (!ok.at(i) || metadata.at(i).lastModified.toMSecsSinceEpoch() != mtimes.at(i)) {
+                changed.append(paths.at(i));
             }
         }
+        
+        QMetaObject::invokeMethod(this, [this, generation, changed]() {
+            if (generation == scanGeneration && !changed.isEmpty()) {
+                refreshDirectories(changed);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DirectoryTreeReader::startWatching()
+{
+    directoryWatcher->clear();
+    
+    // 取消后的目录树不完整，不监视
+    if (isCancelled) {
+        return;
     }
     
-    for (const QFileInfo &info : entries) {
-        if (isCancelled) {
-            return;
+    for (const QString &path : listedDirectories()) {
+        if (!directoryWatcher->addPath(path)) {
+            qWarning() << "目录监视数量已达系统上限，共监视" << directoryWatcher->watchCount() << "个目录";
+            break;
+        }
+    }
+}
+
+QStringList DirectoryTreeReader::listedDirectories() const
+{
+    // 从根节点沿子节点遍历，只包含当前树中仍然存在的节点
+    QStringList paths;
+    QVector<int> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const int node = stack.takeLast();
+        if (!treeModel->isListed(node)) {
+            continue;
         }
         
-        // 更新进度
-        processed++;
-        int progressValue = (processed * 100) / total;
-        emit progressUpdated(progressValue);
+        paths.append(treeModel->filePath(node));
+        const int count = treeModel->childCount(node);
+        for (int i = count - 1; i >= 0; --i) {
+            const int child = treeModel->child(node, i);
+            if (treeModel->isDirectory(child)) {
+                stack.append(child);
+            }
+        }
+    }
+    return paths;
+}
+
+void DirectoryTreeReader::refreshDirectories(const QStringList &paths)
+{
+    // 完整读取期间的变化由读取结果本身覆盖
+    if (watcher->isRunning() || isCancelled) {
+        return;
+    }
+    
+    pendingRefreshPaths.append(paths);
+    if (!refreshRunning) {
+        startNextRefresh();
+    }
+}
+
+void DirectoryTreeReader::refreshAllDirectories()
+{
+    refreshDirectories(listedDirectories());
+}
+
+void DirectoryTreeReader::requestListing(int node)
+{
+    if (!lazyLoading || isCancelled) {
+        return;
+    }
+    
+    // 初始读取范围内的目录由正在进行的读取负责
+    if (watcher->isRunning() && treeModel->nodeDepth(node) + 1 <= maxDepth) {
+        return;
+    }
+    
+    // 先监视再读取，避免漏掉读取期间的变化
+    const QString path = treeModel->filePath(node);
+    if (watchEnabled) {
+        directoryWatcher->addPath(path);
+    }
+    
+    // 用户正在查看的目录排在最前面
+    pendingRefreshPaths.removeAll(path);
+    pendingRefreshPaths.prepend(path);
+    if (!refreshRunning && !watcher->isRunning()) {
+        startNextRefresh();
+    }
+}
+
+void DirectoryTreeReader::startNextRefresh()
+{
+    pendingRefreshPaths.removeDuplicates();
+    const QStringList paths = pendingRefreshPaths.mid(0, RefreshBatchSize);
+    pendingRefreshPaths.remove(0, paths.size());
+    
+    // 只读取仍在树中的目录
+    QStringList jobs;
+    for (const QString &path : paths) {
+        const int node = treeModel->findNode(path);
+        if (node >= 0 && treeModel->isDirectory(node)) {
+            jobs.append(path);
+        }
+    }
+    if (jobs.isEmpty()) {
+        if (!pendingRefreshPaths.isEmpty()) {
+            startNextRefresh();
+        }
+        return;
+    }
+    
+    refreshRunning = true;
+    const int generation = scanGeneration;
+    refreshFuture = QtConcurrent::run([this, generation, jobs]() {
+        QVector<RefreshResult> results;
+        results.reserve(jobs.size());
+        for (const QString &job : jobs) {
+            RefreshResult result;
+            result.path = job;
+            listDirectory(job, FileFilterUtil::DirectoryVerdict::TestEntries, result.entries);
+            results.append(result);
+        }
         
-        QString entryName = info.fileName();
-        QString entryPath = info.filePath();
+        QMetaObject::invokeMethod(this, [this, generation, results]() {
+            applyRefresh(generation, results);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DirectoryTreeReader::applyRefresh(int generation, const QVector<RefreshResult> &results)
+{
+    refreshRunning = false;
+    
+    // 丢弃已被新一次读取取代或被取消的结果
+    if (generation != scanGeneration || isCancelled) {
+        return;
+    }
+    
+    for (const RefreshResult &result : results) {
+        const int node = treeModel->findNode(result.path);
+        if (node < 0) {
+            continue;
+        }
         
-        // 特殊处理build目录
-        if (info.isDir() && allowBuildExclusion) {
-            QString lowerName = entryName.toLower();
-            if (lowerName == "build" || entryPath.toLower().contains("/build/")) {
-                // 在顶层目录输出排除信息
-                if (currentDepth == 1) {
-                    qDebug() << "排除:" << entryName << "(build目录自动排除)";
-                }
-                excluded++;
-                continue;
-            }
+        QVector<DirectoryTreeModel::Child> children;
+        children.reserve(result.entries.size());
+        for (const DirectoryWalker::Entry &entry : result.entries) {
+            children.append(DirectoryTreeModel::Child{entry.name, entry.isDir, entry.size, entry.modified});
         }
         
-        // 检查是否应该排除此文件/目录
-        bool shouldExclude = fileFilter.shouldExcludeFile(entryName, entryPath);
+        const DirectoryTreeModel::ChildrenUpdate update = treeModel->replaceChildren(node, children);
+        for (const QString &name : update.removedDirectories) {
+            directoryWatcher->removePath(DirectoryWalker::childPath(result.path, name));
+        }
         
-        // 目录的特殊处理
-        if (shouldExclude && info.isDir() && hasFileTypeIncludeRule) {
-            // 如果有文件类型包含规则(如*.cpp)，并且没有明确排除此目录的规则，则继续遍历
-            bool hasSpecificDirExcludeRule = false;
-            for (const FileFilterUtil::FilterRule &rule : fileFilter.getFilterRules()) {
-                if (!rule.enabled || rule.filterMode != FileFilterUtil::FilterMode::Exclude) continue;
-                
-                // 检查是否有明确针对该目录的排除规则
-                QString pattern = rule.pattern;
-                pattern = pattern.replace('\\', '/');
-                if (pattern.endsWith('/')) {
-                    pattern = pattern.left(pattern.length() - 1);
-                }
-                
-                if (entryName.compare(pattern, Qt::CaseInsensitive) == 0 || 
-                    entryPath.contains("/" + pattern + "/", Qt::CaseInsensitive)) {
-                    hasSpecificDirExcludeRule = true;
-                    break;
-                }
-            }
-            
-            // 如果没有明确排除此目录的规则，则允许继续遍历
-            if (!hasSpecificDirExcludeRule) {
-                shouldExclude = false;
-                if (currentDepth == 1) {
-                    qDebug() << "允许目录:" << entryName << "(有文件类型包含规则，允许遍历)";
+        // 新出现的目录在深度范围内时先监视再读取，避免漏掉读取期间的变化；
+        // 按需读取的目录已被展开时，其子目录在视图中可见，排在队尾预读一层
+        if (treeModel->nodeDepth(node) + 2 <= maxDepth || (lazyLoading && treeModel->isFetched(node))) {
+            for (int added : update.addedDirectories) {
+                const QString path = treeModel->filePath(added);
+                if (watchEnabled) {
+                    directoryWatcher->addPath(path);
                 }
+                pendingRefreshPaths.append(path);
             }
         }
+    }
+    
+    emit treeUpdated();
+    
+    if (!pendingRefreshPaths.isEmpty()) {
+        startNextRefresh();
+    } else if (snapshotEnabled) {
+        snapshotTimer->start();
+    }
+}
+
+void DirectoryTreeReader::flushPendingNodes(bool force)
+{
+    if (pendingBatch.nodes.isEmpty() && pendingBatch.listings.isEmpty() && pendingBatch.completedRollups.isEmpty()) {
+        return;
+    }
+    if (!force && pendingBatch.nodes.size() < NodeBatchSize && batchTimer.elapsed() < NodeBatchInterval) {
+        return;
+    }
+    
+    // 以排队方式提交，工作线程不等待主线程处理完成
+    DirectoryTreeModel::NodeBatch batch;
+    std::swap(batch, pendingBatch);
+    const int generation = scanGeneration;
+    QMetaObject::invokeMethod(this, [this, generation, batch = std::move(batch)]() {
+        // 丢弃已被新一次读取取代的批次
+        if (generation == scanGeneration) {
+            treeModel->appendBatch(batch);
+        }
+    }, Qt::QueuedConnection);
+    batchTimer.restart();
+    
+    // 导出的记录与节点批次以相同的节奏写入设备
+    if (exporter) {
+        exporter->flush();
+    }
+}
+
+void DirectoryTreeReader::readDirectory(DirectoryWalker &walker, int slot, int nodeId, const QString &path)
+{
+    if (isCancelled) {
+        return;
+    }
+    
+    // 按深度优先顺序取出结果，工作线程可能已经提前读取了后面的目录
+    const QVector<DirectoryWalker::Entry> entries = takeListing(walker, slot, path);
+    const int firstChild = appendListing(nodeId, entries);
+    flushPendingNodes();
+    
+    // 递归处理已派发读取的子目录
+    for (int i = 0; i < entries.size(); ++i) {
+        if (isCancelled) {
+            return;
+        }
+        if (entries.at(i).slot >= 0) {
+            readDirectory(walker, entries.at(i).slot, firstChild + i, DirectoryWalker::childPath(path, entries.at(i).name));
+        }
+    }
+}
+
+void DirectoryTreeReader::readBreadthFirst(DirectoryWalker &walker, int rootSlot, const QString &rootPath)
+{
+    struct PendingDirectory {
+        int slot;       ///< 读取结果的槽位
+        int nodeId;     ///< 目录对应的节点下标
+        int depth;      ///< 目录深度
+        QString path;   ///< 目录路径
+    };
+    
+    // 与遍历器的取出顺序一致：先取完一层再取下一层
+    std::deque<PendingDirectory> queue;
+    queue.push_back(PendingDirectory{rootSlot, 0, 1, rootPath});
+    int currentDepth = 1;
+    
+    while (!queue.empty() && !isCancelled) {
+        const PendingDirectory directory = queue.front();
+        queue.pop_front();
         
-        if (shouldExclude) {
-            // 仅在顶层目录输出排除信息，避免过多输出
-            if (currentDepth == 1) {
-                qDebug() << "排除:" << entryName << "(过滤规则匹配)";
-            }
-            excluded++;
-            continue;
+        // 一层组装完毕后立即提交，不等待批次积满，浅层结构尽快出现在视图中
+        if (directory.depth != currentDepth) {
+            flushPendingNodes(true);
+            currentDepth = directory.depth;
         }
         
-        // 创建树项并添加到树中，使用QMetaObject::invokeMethod确保UI更新在主线程进行
-        QTreeWidgetItem *item = nullptr;
-        QMetaObject::invokeMethod(this, [this, &item, entryName, entryPath, info, parent]() {
-            item = new QTreeWidgetItem();
-            item->setText(0, entryName);
-            item->setText(2, entryPath);
-            item->setFlags(item->flags() | Qt::ItemIsEditable);
-            
-            if (info.isDir()) {
-                item->setText(1, "目录");
-                item->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_DirIcon));
-            } else {
-                item->setText(1, "文件");
-                item->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_FileIcon));
+        const QVector<DirectoryWalker::Entry> entries = takeListing(walker, directory.slot, directory.path);
+        const int firstChild = appendListing(directory.nodeId, entries);
+        for (int i = 0; i < entries.size(); ++i) {
+            if (entries.at(i).slot >= 0) {
+                queue.push_back(PendingDirectory{entries.at(i).slot, firstChild + i, directory.depth + 1,
+                                                 DirectoryWalker::childPath(directory.path, entries.at(i).name)});
             }
-            
-            parent->addChild(item);
-            return;
-        }, Qt::BlockingQueuedConnection);
-        
-        // 如果是目录，递归处理
-        if (info.isDir() && item != nullptr) {
-            readDirectory(entryPath, item, currentDepth + 1);
         }
+        flushPendingNodes();
+    }
+}
+
+QVector<DirectoryWalker::Entry> DirectoryTreeReader::takeListing(DirectoryWalker &walker, int slot, const QString &path)
+{
+    bool duplicate = false;
+    const QVector<DirectoryWalker::Entry> entries = walker.take(slot, &duplicate);
+    
+    // 已经从其他路径读取过的目录按空目录处理，也不记录修改时间，快照校验时不会重新展开它
+    if (duplicate && snapshotEnabled) {
+        QMutexLocker locker(&mtimeMutex);
+        directoryMtimes.remove(path);
     }
     
-    // 仅在顶层目录输出排除统计
-    if (currentDepth == 1 && excluded > 0) {
-        qDebug() << "共排除" << excluded << "个文件/目录";
+    // 按组装顺序统计进度：重复目录和超出深度的目录不会继续读取，不计入已发现的目录
+    qint64 directories = 0;
+    for (const DirectoryWalker::Entry &entry : entries) {
+        directories += entry.slot >= 0 ? 1 : 0;
     }
+    progressTracker->addTotal(directories);
+    progressTracker->addCompleted(1);
+    return entries;
 }
 
-QString DirectoryTreeReader::generateTextRepresentation(QTreeWidgetItem *item, int level)
+int DirectoryTreeReader::appendListing(int nodeId, const QVector<DirectoryWalker::Entry> &entries)
 {
-    if (!item) {
-        return QString();
+    // 追加子节点并记录本目录的子节点范围，使同一目录的子节点在节点数组中连续存放
+    const int firstChild = nextNodeId;
+    for (const DirectoryWalker::Entry &entry : entries) {
+        const QByteArray utf8Name = entry.name.toUtf8();
+        
+        DirectoryTreeModel::Node node;
+        node.parent = nodeId;
+        node.firstChild = -1;
+        node.childCount = 0;
+        node.nameOffset = nextNameOffset;
+        node.nameLength = static_cast<quint16>(utf8Name.size());
+        node.flags = entry.isDir ? DirectoryTreeModel::DirectoryFlag : 0;
+        node.reserved = 0;
+        
+        pendingBatch.nodes.append(node);
+        pendingBatch.names.append(utf8Name);
+        nextNameOffset += node.nameLength;
+        ++nextNodeId;
+    }
+    pendingBatch.listings.append(DirectoryTreeModel::Listing{nodeId, firstChild, static_cast<qint32>(entries.size())});
+    if (exporter) {
+        exporter->addListing(nodeId, firstChild, entries);
+    }
+    
+    if (!computeRollups) {
+        return firstChild;
+    }
+    
+    // 文件的统计立即确定；会继续读取的子目录等其子树完成后再合计，超出深度的子目录按空目录计
+    PendingRollup &pending = pendingRollups[nodeId];
+    pending.remaining = 0;
+    for (int i = 0; i < entries.size(); ++i) {
+        const DirectoryWalker::Entry &entry = entries.at(i);
+        if (!entry.isDir) {
+            const DirectoryTreeModel::Rollup rollup = DirectoryTreeModel::Rollup::file(entry.size, entry.modified);
+            pending.total.add(rollup);
+            pendingBatch.rollups.append(rollup);
+        } else if (entry.slot >= 0) {
+            pendingBatch.rollups.append(DirectoryTreeModel::Rollup::unknown());
+            PendingRollup child;
+            child.parent = nodeId;
+            pendingRollups.insert(firstChild + i, child);
+            ++pending.remaining;
+        } else {
+            pendingBatch.rollups.append(DirectoryTreeModel::Rollup::empty());
+        }
+    }
+    if (pending.remaining == 0) {
+        completeRollup(nodeId);
+    }
+    return firstChild;
+}
+
+void DirectoryTreeReader::completeRollup(int nodeId)
+{
+    // 最后一个子目录完成时父目录随之完成，沿父节点向上传递
+    while (nodeId >= 0) {
+        const PendingRollup finished = pendingRollups.take(nodeId);
+        pendingBatch.completedRollups.append(DirectoryTreeModel::RollupUpdate{nodeId, finished.total});
+        if (finished.parent < 0) {
+            return;
+        }
+        
+        PendingRollup &parent = pendingRollups[finished.parent];
+        parent.total.add(finished.total);
+        nodeId = --parent.remaining == 0 ? finished.parent : -1;
+    }
+}
+
+void DirectoryTreeReader::listDirectory(const QString &path, FileFilterUtil::DirectoryVerdict inherited,
+                                        QVector<DirectoryWalker::Entry> &result, DirectoryScanner::FileId *directoryId)
+{
+    if (isCancelled) {
+        return;
+    }
+
+    // 由扫描后端读取目录，条目类型来自目录项本身，无需对每个条目调用stat；
+    // 隐藏的忽略文件不在条目中，由扫描在同一次读取中单独给出
+    QVector<DirectoryScanner::Entry> entries;
+    QStringList ignoreFiles;
+    qint64 modified = 0;
+    if (!DirectoryScanner::scan(path, readFiles, entries, snapshotEnabled ? &modified : nullptr,
+                                directoryId, readFiles && (computeRollups || exporter),
+                                ignoreFilesEnabled ? &ignoreFiles : nullptr)) {
+        return;
+    }
+    
+    // 重复到达的目录在组装时才能确定，到时再撤销这里记录的修改时间
+    if (snapshotEnabled) {
+        QMutexLocker locker(&mtimeMutex);
+        directoryMtimes.insert(path, modified);
     }
     
-    QString result;
+    result.reserve(entries.size());
     
-    // 根节点特殊处理
-    if (level == 0) {
-        result = item->text(0) + "/\n";
-    } else {
-        // 构建前缀
-        QString prefix;
-        for (int i = 0; i < level - 1; i++) {
-            prefix += "│   ";
+    // 规则在设置时已编译；目录路径只规范化一次，条目类型直接来自扫描结果，过滤时不再访问文件系统
+    const QSharedPointer<const FilterMatcher> matcher = fileFilter.matcher();
+    const QString filterDirectory = FileFilterUtil::normalizePath(path, FileFilterUtil::EntryKind::Directory);
+    
+    // 整个子树的决策只在没有从父目录继承时计算一次，全部排除时不必再看条目
+    const FileFilterUtil::DirectoryVerdict verdict = matcher->directoryVerdict(filterDirectory, inherited);
+    if (verdict == FileFilterUtil::DirectoryVerdict::ExcludeAll) {
+        return;
+    }
+    
+    // 本目录的忽略文件压入继承的规则栈，子目录读取时直接共享，不再解析
+    QSharedPointer<const IgnoreStack> ignoreStack;
+    if (ignoreFilesEnabled) {
+        ignoreStack = ignoreStacks.enter(filterDirectory, ignoreFiles);
+    }
+    
+    // 所有条目共用一个路径缓冲区，逐条目过滤时不分配内存
+    QString entryPath;
+    entryPath.reserve(filterDirectory.size() + MaxNameLength + 1);
+    entryPath += filterDirectory;
+    
+    for (const DirectoryScanner::Entry &entry : entries) {
+        if (isCancelled) {
+            return;
         }
         
-        // 添加当前项的连接线
-        if (level > 0) {
-            prefix += "├── ";
+        const QString &entryName = entry.name;
+        const FileFilterUtil::EntryKind kind = entry.isDir() ? FileFilterUtil::EntryKind::Directory
+                                                             : FileFilterUtil::EntryKind::File;
+        FileFilterUtil::replaceChildName(entryPath, filterDirectory.size(), entryName, kind);
+        
+        if (ignoreStack && ignoreStack->isIgnored(entryPath, entry.isDir())) {
+            FILTER_TRACE(FilterTrace::Scanner, FilterTrace::Event::IgnoreMatched, entryPath, -1);
+            if (entry.isDir()) {
+                FILTER_TRACE(FilterTrace::Scanner, FilterTrace::Event::DirectoryPruned, entryPath, -1);
+            }
+            continue;
         }
         
-        // 添加当前项
-        if (item->text(1) == "目录") {
-            result = prefix + item->text(0) + "/\n";
-        } else {
-            result = prefix + item->text(0) + "\n";
+        // 被排除的目录不放入结果，遍历器不会打开它，整个子树都被剪掉
+        if (!matcher->shouldInclude(entryPath, filterRootLength, kind, verdict)) {
+            if (entry.isDir()) {
+                FILTER_TRACE(FilterTrace::Scanner, FilterTrace::Event::DirectoryPruned, entryPath, -1);
+            }
+            continue;
         }
+        
+        DirectoryWalker::Entry kept(entryName, entry.isDir());
+        kept.size = entry.size;
+        kept.modified = entry.modified;
+        kept.context = static_cast<quint8>(verdict);
+        kept.id = entry.id;
+        result.append(kept);
     }
+}
+
+bool DirectoryTreeReader::renderText(int node, QByteArray &buffer, QIODevice *device) const
+{
+    if (node < 0 || node >= treeModel->nodeCount()) {
+        return true;
+    }
+    
+    // 起始节点不带前缀
+    buffer.append(treeModel->nodeNameUtf8(node));
+    buffer.append("/\n");
     
-    // 处理子项
-    int childCount = item->childCount();
-    for (int i = 0; i < childCount; ++i) {
-        QTreeWidgetItem *child = item->child(i);
+    struct Frame {
+        int node;   ///< 目录节点
+        int row;    ///< 下一个要输出的子项
+    };
+    QVector<Frame> stack;
+    stack.append({node, 0});
+    std::vector<bool> lastFlags;    // 每一层祖先是否为最后一个子项
+    QByteArray prefix;
+    
+    while (!stack.isEmpty()) {
+        const int parent = stack.last().node;
+        const int row = stack.last().row++;
+        const int count = treeModel->childCount(parent);
         
-        // 最后一个子项使用不同的连接线
-        if (i == childCount - 1) {
-            // 保存原始结果
-            QString originalResult = result;
-            
-            // 将下一级的"├──"替换为"└──"
-            QString childText = generateTextRepresentation(child, level + 1);
-            if (level >= 0) {
-                childText.replace(level * 4, 4, "└── ");
-                
-                // 将后续行的"│   "替换为"    "
-                int pos = childText.indexOf('\n');
-                while (pos >= 0 && pos < childText.length() - 1) {
-                    int prefixPos = pos + 1 + level * 4;
-                    if (prefixPos + 4 <= childText.length() && 
-                        childText.mid(prefixPos, 4) == "│   ") {
-                        childText.replace(prefixPos, 4, "    ");
-                    }
-                    pos = childText.indexOf('\n', pos + 1);
-                }
+        if (row >= count) {
+            stack.removeLast();
+            if (!lastFlags.empty()) {
+                prefix.chop(lastFlags.back() ? BlankIndentBytes : BranchIndentBytes);
+                lastFlags.pop_back();
             }
-            result = originalResult + childText;
-        } else {
-            result += generateTextRepresentation(child, level + 1);
+            continue;
+        }
+        
+        const int child = treeModel->child(parent, row);
+        const bool isLast = (row == count - 1);
+        
+        buffer.append(prefix);
+        buffer.append(isLast ? "└── " : "├── ");
+        buffer.append(treeModel->nodeNameUtf8(child));
+        buffer.append(treeModel->isDirectory(child) ? "/\n" : "\n");
+        
+        if (device && buffer.size() >= TextChunkSize) {
+            if (device->write(buffer) != buffer.size()) {
+                return false;
+            }
+            buffer.clear();
+        }
+        
+        if (treeModel->childCount(child) > 0) {
+            prefix.append(isLast ? "    " : "│   ");
+            lastFlags.push_back(isLast);
+            stack.append({child, 0});
         }
     }
     
-    return result;
-} 
\ No newline at end of file
+    return true;
+}
@@ -0,0 +1,378 @@
+#include "directorywalker.h"
+
+#include <QThread>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace {
+// 等待结果时的轮询间隔（毫秒），用于及时响应调用方的取消
+const unsigned long CancelPollInterval = 50;
+}
+
+DirectoryWalker::DirectoryWalker(ListFunction listFunction, CancelFunction cancelFunction, int threadCount)
+    : listFunction(std::move(listFunction))
+    , cancelFunction(std::move(cancelFunction))
+    , threadCount(threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount()))
+    , maxDepth(1)
+    , order(Order::DepthFirst)
+    , deduplicateFiles(false)
+    , queuedItems(0)
+    , pendingItems(0)
+    , cancelled(0)
+{
+    threadPool.setMaxThreadCount(this->threadCount);
+    for (int i = 0; i < this->threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    cancel();
+    threadPool.waitForDone();
+}
+
+void DirectoryWalker::setMaxDepth(int depth)
+{
+    maxDepth = depth;
+}
+
+void DirectoryWalker::setOrder(Order order)
+{
+    this->order = order;
+}
+
+void DirectoryWalker::setDeduplicateFiles(bool enabled)
+{
+    deduplicateFiles = enabled;
+}
+
+QString DirectoryWalker::childPath(const QString &dirPath, const QString &name)
+{
+    if (dirPath.endsWith('/')) {
+        return dirPath + name;
+    }
+    return dirPath + '/' + name;
+}
+
+int DirectoryWalker::start(const QString &rootPath, int rootDepth)
+{
+    int rootSlot = 0;
+    {
+        QMutexLocker locker(&slotMutex);
+        rootSlot = static_cast<int>(slots.size());
+        slots.emplace_back();
+    }
+
+    // 根目录超过最大深度时直接视为空目录
+    if (rootDepth > maxDepth) {
+        QMutexLocker locker(&slotMutex);
+        slots[rootSlot].ready = true;
+        return rootSlot;
+    }
+
+    std::vector<WorkItem> rootItems;
+    rootItems.push_back(WorkItem{rootPath, rootDepth, rootSlot, 0});
+    push(0, rootItems);
+
+    for (int i = 0; i < threadCount; ++i) {
+        threadPool.start([this, i]() {
+            workerLoop(i);
+        });
+    }
+
+    return rootSlot;
+}
+
+QVector<DirectoryWalker::Entry> DirectoryWalker::take(int slot, bool *duplicate)
+{
+    if (duplicate) {
+        *duplicate = false;
+    }
+
+    QMutexLocker locker(&slotMutex);
+    if (slot < 0 || slot >= static_cast<int>(slots.size())) {
+        return QVector<Entry>();
+    }
+
+    while (!slots[slot].ready) {
+        if (cancelled.loadAcquire()) {
+            return QVector<Entry>();
+        }
+        slotReady.wait(&slotMutex, CancelPollInterval);
+
+        // 等待期间检查调用方是否已取消
+        if (!slots[slot].ready && cancelFunction && cancelFunction()) {
+            locker.unlock();
+            cancel();
+            return QVector<Entry>();
+        }
+    }
+
+    // 取出后释放槽位中的数据，每个槽位只会被取一次
+    QVector<Entry> entries;
+    entries.swap(slots[slot].entries);
+
+    // 按取出顺序判定重复：先取出的路径保留，之后到达的同一目录按空目录处理，其下的目录不再读取
+    const DirectoryScanner::FileId &id = slots[slot].id;
+    if (id.isValid()) {
+        const qsizetype before = takenIds.size();
+        takenIds.insert(id);
+        if (takenIds.size() == before) {
+            for (const Entry &entry : entries) {
+                if (entry.slot >= 0) {
+                    discard(entry.slot);
+                }
+            }
+            if (duplicate) {
+                *duplicate = true;
+            }
+            return QVector<Entry>();
+        }
+    }
+
+    // 同一文件的其他硬链接已经取出过
+    if (deduplicateFiles) {
+        const auto repeated = [this](const Entry &entry) {
+            if (entry.isDir || !entry.id.isValid()) {
+                return false;
+            }
+            const qsizetype before = takenIds.size();
+            takenIds.insert(entry.id);
+            return takenIds.size() == before;
+        };
+        entries.erase(std::remove_if(entries.begin(), entries.end(), repeated), entries.end());
+    }
+    return entries;
+}
+
+void DirectoryWalker::cancel()
+{
+    cancelled.storeRelease(1);
+
+    {
+        QMutexLocker locker(&idleMutex);
+        workAvailable.wakeAll();
+    }
+    {
+        QMutexLocker locker(&slotMutex);
+        slotReady.wakeAll();
+    }
+}
+
+bool DirectoryWalker::isCancelled()
+{
+    if (cancelled.loadAcquire()) {
+        return true;
+    }
+    if (cancelFunction && cancelFunction()) {
+        cancel();
+        return true;
+    }
+    return false;
+}
+
+void DirectoryWalker::workerLoop(int index)
+{
+    while (true) {
+        WorkItem item;
+        if (acquireWork(index, item)) {
+            if (!isCancelled()) {
+                process(index, item);
+            }
+
+            // 最后一个工作项完成后唤醒所有空闲线程退出
+            if (pendingItems.fetchAndSubOrdered(1) == 1) {
+                QMutexLocker locker(&idleMutex);
+                workAvailable.wakeAll();
+            }
+            continue;
+        }
+
+        // 没有可取的工作：如果所有工作都已完成则退出，否则等待其他线程派发新目录
+        QMutexLocker locker(&idleMutex);
+        while (queuedItems.loadAcquire() == 0 && pendingItems.loadAcquire() > 0 && !cancelled.loadAcquire()) {
+            workAvailable.wait(&idleMutex);
+        }
+        if (cancelled.loadAcquire() || pendingItems.loadAcquire() == 0) {
+            return;
+        }
+    }
+}
+
+bool DirectoryWalker::acquireWork(int index, WorkItem &item)
+{
+    if (order == Order::BreadthFirst) {
+        return acquireShallowest(item);
+    }
+
+    // 先从自己的队尾取（最近派发的子目录，深度优先）
+    {
+        WorkerQueue &own = *queues[index];
+        QMutexLocker locker(&own.mutex);
+        if (!own.items.empty()) {
+            item = std::move(own.items.back());
+            own.items.pop_back();
+            queuedItems.fetchAndSubOrdered(1);
+            return true;
+        }
+    }
+
+    // 再从其他线程的队首窃取（通常是更靠近根的大子树）
+    for (int offset = 1; offset < threadCount; ++offset) {
+        WorkerQueue &victim = *queues[(index + offset) % threadCount];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.items.empty()) {
+            item = std::move(victim.items.front());
+            victim.items.pop_front();
+            queuedItems.fetchAndSubOrdered(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool DirectoryWalker::acquireShallowest(WorkItem &item)
+{
+    // 每个队列内按派发顺序排列，队首深度最小，比较各队首即可找到全局最浅的目录
+    while (queuedItems.loadAcquire() > 0) {
+        int best = -1;
+        int bestDepth = 0;
+        for (int i = 0; i < threadCount; ++i) {
+            WorkerQueue &queue = *queues[i];
+            QMutexLocker locker(&queue.mutex);
+            if (!queue.items.empty() && (best < 0 || queue.items.front().depth < bestDepth)) {
+                best = i;
+                bestDepth = queue.items.front().depth;
+            }
+        }
+        if (best < 0) {
+            return false;
+        }
+
+        // 比较之后队首可能已被其他线程取走，此时重新查找
+        WorkerQueue &queue = *queues[best];
+        QMutexLocker locker(&queue.mutex);
+        if (!queue.items.empty()) {
+            item = std::move(queue.items.front());
+            queue.items.pop_front();
+            queuedItems.fetchAndSubOrdered(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectoryWalker::process(int index, const WorkItem &item)
+{
+    // 位于重复目录之下的目录不会被呈现，不再读取
+    {
+        QMutexLocker locker(&slotMutex);
+        Slot &slot = slots[item.slot];
+        if (slot.discarded) {
+            slot.ready = true;
+            slotReady.wakeAll();
+            return;
+        }
+    }
+
+    QVector<Entry> entries;
+    DirectoryScanner::FileId directoryId;
+    listFunction(item.path, item.depth, item.context, entries, directoryId);
+
+    // 为需要继续读取的子目录分配槽位
+    std::vector<WorkItem> children;
+    const int childDepth = item.depth + 1;
+    {
+        QMutexLocker locker(&slotMutex);
+        slots[item.slot].id = directoryId;
+
+        // 与祖先目录相同时形成了环，祖先总是先被取出，这里必然判定为重复，子目录不必再读取
+        const bool skipChildren = slots[item.slot].discarded || isAncestor(item.slot, directoryId);
+        if (childDepth <= maxDepth && !skipChildren) {
+            for (Entry &entry : entries) {
+                if (!entry.isDir) {
+                    continue;
+                }
+                entry.slot = static_cast<int>(slots.size());
+                slots.emplace_back();
+                slots.back().parent = item.slot;
+                children.push_back(WorkItem{childPath(item.path, entry.name), childDepth, entry.slot, entry.context});
+            }
+        }
+
+        // 不会被呈现的目录不保留条目
+        Slot &slot = slots[item.slot];
+        if (!skipChildren) {
+            slot.entries = std::move(entries);
+        }
+        slot.ready = true;
+        slotReady.wakeAll();
+    }
+
+    if (!children.empty()) {
+        // 深度优先时逆序压入，使第一个子目录位于队尾，最先被本线程取出；
+        // 广度优先时按顺序压入，从队首取出
+        if (order == Order::DepthFirst) {
+            std::reverse(children.begin(), children.end());
+        }
+        push(index, children);
+    }
+}
+
+bool DirectoryWalker::isAncestor(int slot, const DirectoryScanner::FileId &id) const
+{
+    if (!id.isValid()) {
+        return false;
+    }
+    for (int parent = slots[slot].parent; parent >= 0; parent = slots[parent].parent) {
+        if (slots[parent].id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectoryWalker::discard(int slot)
+{
+    // 已读取的槽位继续丢弃其子目录；尚未读取的由工作线程跳过，读取中的不再派发子目录
+    std::vector<int> pending{slot};
+    while (!pending.empty()) {
+        Slot &current = slots[pending.back()];
+        pending.pop_back();
+        current.discarded = true;
+        for (const Entry &entry : current.entries) {
+            if (entry.slot >= 0) {
+                pending.push_back(entry.slot);
+            }
+        }
+        current.entries.clear();
+    }
+}
+
+void DirectoryWalker::push(int index, std::vector<WorkItem> &items)
+{
+    if (items.empty()) {
+        return;
+    }
+
+    const int count = static_cast<int>(items.size());
+    pendingItems.fetchAndAddOrdered(count);
+    queuedItems.fetchAndAddOrdered(count);
+    {
+        WorkerQueue &own = *queues[index];
+        QMutexLocker locker(&own.mutex);
+        for (WorkItem &item : items) {
+            own.items.push_back(std::move(item));
+        }
+    }
+
+    QMutexLocker locker(&idleMutex);
+    if (count == 1) {
+        workAvailable.wakeOne();
+    } else {
+        workAvailable.wakeAll();
+    }
+}
@@ -0,0 +1,254 @@
+#include "directorywatcher.h"
+#include "ignorestack.h"
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// 最后一个事件之后等待的安静时间（毫秒）
+const int CoalesceDelay = 200;
+// 持续有事件时，从第一个事件到发出通知的最长时间（毫秒）
+const qint64 MaxCoalesceDelay = 1000;
+
+#ifdef Q_OS_LINUX
+// 只关心影响目录树结构的事件；文件写入完成只用来发现忽略文件的修改，属性的修改不订阅
+const uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE
+                           | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+}
+
+DirectoryWatcher::DirectoryWatcher(QObject *parent)
+    : QObject(parent)
+    , inotifyFd(-1)
+    , notifier(nullptr)
+    , fallbackWatcher(nullptr)
+    , coalesceTimer(new QTimer(this))
+{
+    coalesceTimer->setSingleShot(true);
+    connect(coalesceTimer, &QTimer::timeout, this, &DirectoryWatcher::flushChanges);
+
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0) {
+        notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, &DirectoryWatcher::readInotifyEvents);
+        return;
+    }
+#endif
+
+    // inotify不可用，使用Qt的跨平台实现
+    fallbackWatcher = new QFileSystemWatcher(this);
+    connect(fallbackWatcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &path) {
+        markDirty(path);
+    });
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        // 关闭描述符会同时移除所有监视
+        notifier->setEnabled(false);
+        close(inotifyFd);
+    }
+#endif
+}
+
+bool DirectoryWatcher::addPath(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        const int wd = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(), WatchMask);
+        if (wd < 0) {
+            return false;
+        }
+
+        // 同一个目录以新路径出现（例如被改名）时内核返回原来的描述符
+        const QString oldPath = watchPaths.value(wd);
+        if (!oldPath.isEmpty() && oldPath != path) {
+            pathWatches.remove(oldPath);
+        }
+        watchPaths.insert(wd, path);
+        pathWatches.insert(path, wd);
+        return true;
+    }
+#endif
+
+    if (!fallbackWatcher->addPath(path)) {
+        return false;
+    }
+    pathWatches.insert(path, -1);
+    return true;
+}
+
+void DirectoryWatcher::removePath(const QString &path)
+{
+    const QString prefix = path.endsWith('/') ? path : path + '/';
+
+    QStringList paths;
+    for (auto it = pathWatches.constBegin(); it != pathWatches.constEnd(); ++it) {
+        if (it.key() == path || it.key().startsWith(prefix)) {
+            paths.append(it.key());
+        }
+    }
+    for (const QString &watchedPath : paths) {
+        removeWatch(watchedPath);
+    }
+}
+
+void DirectoryWatcher::clear()
+{
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        for (auto it = watchPaths.constBegin(); it != watchPaths.constEnd(); ++it) {
+            inotify_rm_watch(inotifyFd, it.key());
+        }
+    }
+#endif
+    if (fallbackWatcher && !fallbackWatcher->directories().isEmpty()) {
+        fallbackWatcher->removePaths(fallbackWatcher->directories());
+    }
+
+    watchPaths.clear();
+    pathWatches.clear();
+    dirtyPaths.clear();
+    coalesceTimer->stop();
+}
+
+int DirectoryWatcher::watchCount() const
+{
+    return pathWatches.size();
+}
+
+void DirectoryWatcher::readInotifyEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    bool overflow = false;
+
+    while (true) {
+        const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length;) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+
+            const QString path = watchPaths.value(event->wd);
+            if (path.isEmpty()) {
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                // 目录已被删除或监视已被移除
+                watchPaths.remove(event->wd);
+                if (pathWatches.value(path) == event->wd) {
+                    pathWatches.remove(path);
+                }
+                continue;
+            }
+            if (event->mask & IN_MOVE_SELF) {
+                // 目录被移走后原路径失效，父目录的变化会让它以新路径重新加入
+                removeWatch(path);
+                continue;
+            }
+            if (event->mask & IN_DELETE_SELF) {
+                continue;
+            }
+
+            // 忽略文件被修改、创建、删除或移动时，整个子树的过滤结果都可能改变；
+            // 忽略文件都以'.'开头，先比较首字节，其他文件的写入不必转换名称
+            if (event->len > 0 && event->name[0] == '.'
+                && IgnoreStack::isIgnoreFile(QString::fromUtf8(event->name))) {
+                markSubtreeDirty(path);
+                continue;
+            }
+            if (event->mask & IN_CLOSE_WRITE) {
+                continue;
+            }
+
+            markDirty(path);
+        }
+    }
+
+    if (overflow) {
+        // 丢失了事件，逐个目录的变化已不可信
+        dirtyPaths.clear();
+        coalesceTimer->stop();
+        emit rescanRequired();
+    }
+#endif
+}
+
+void DirectoryWatcher::flushChanges()
+{
+    if (dirtyPaths.isEmpty()) {
+        return;
+    }
+
+    QStringList paths(dirtyPaths.cbegin(), dirtyPaths.cend());
+    dirtyPaths.clear();
+    std::sort(paths.begin(), paths.end());
+    emit directoriesChanged(paths);
+}
+
+void DirectoryWatcher::markDirty(const QString &path)
+{
+    if (dirtyPaths.isEmpty()) {
+        firstChangeTimer.start();
+    }
+    dirtyPaths.insert(path);
+
+    // 每个新事件都推迟通知，但不超过从第一个事件起算的最长合并时间
+    const qint64 remaining = MaxCoalesceDelay - firstChangeTimer.elapsed();
+    coalesceTimer->start(static_cast<int>(qBound<qint64>(0, remaining, CoalesceDelay)));
+}
+
+void DirectoryWatcher::markSubtreeDirty(const QString &path)
+{
+    const QString prefix = path.endsWith('/') ? path : path + '/';
+    for (auto it = pathWatches.constBegin(); it != pathWatches.constEnd(); ++it) {
+        if (it.key() == path || it.key().startsWith(prefix)) {
+            markDirty(it.key());
+        }
+    }
+}
+
+void DirectoryWatcher::removeWatch(const QString &path)
+{
+    const int wd = pathWatches.value(path, -2);
+    if (wd == -2) {
+        return;
+    }
+    pathWatches.remove(path);
+
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        watchPaths.remove(wd);
+        inotify_rm_watch(inotifyFd, wd);
+        return;
+    }
+#endif
+
+    fallbackWatcher->removePath(path);
+}
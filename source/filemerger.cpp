@@ -1,4 +1,6 @@
 #include "filemerger.h"
+#include "filefilterutil.h"
+#include "filemetadatacollector.h"
 
 #include <QtConcurrent/QtConcurrent>
 #include <QFile>
@@ -6,6 +8,15 @@
 #include <QTextStream>
 #include <QDebug>
 
+namespace {
+// 每批通过FileMetadataCollector预先打开的文件数，限制同时持有的文件描述符数量
+const int OpenBatchSize = 64;
+// 每批批量查询元数据的文件数，限制同时存在的完整路径数量
+const int MetadataBatchSize = 4096;
+// 预留给条目名的长度，常见文件系统的名称不超过255字节，UTF-16长度不会更长
+const int MaxNameLength = 256;
+}
+
 FileMerger::FileMerger(QObject *parent)
     : QObject(parent)
     , maxDepth(3)
@@ -13,12 +24,17 @@ FileMerger::FileMerger(QObject *parent)
     , useSeparator(true)
     , separator("----------")
     , useExtraction(false)
+    , deduplicateHardLinks(false)
+    , ignoreFilesEnabled(true)
     , watcher(new QFutureWatcher<void>(this))
     , isCancelled(false)
+    , progressTracker(new ProgressTracker(ProgressTracker::Unit::Bytes, this))
 {
     connect(watcher, &QFutureWatcher<void>::finished, this, [this]() {
+        progressTracker->finish();
         emit mergingFinished(foundFiles.size());
     });
+    connect(progressTracker, &ProgressTracker::progressUpdated, this, &FileMerger::progressUpdated);
 }
 
 FileMerger::~FileMerger()
@@ -43,11 +59,25 @@ void FileMerger::setFileFilter(const QString &pattern, bool isRegex)
 {
     fileFilter = pattern;
     useRegex = isRegex;
+    
+    // 表达式只在设置时编译一次，搜索时多个线程共享同一个表达式
+    fileFilterExpression = QRegularExpression();
+    if (!fileFilter.isEmpty()) {
+        fileFilterExpression.setPattern(useRegex ? fileFilter
+                                                 : QRegularExpression::wildcardToRegularExpression(fileFilter));
+        fileFilterExpression.optimize();
+    }
 }
 
 void FileMerger::setFilterRules(const QStringList &rules)
 {
     filterRules = rules;
+    
+    // 规则只在设置时编译一次，搜索时多个线程共享同一个规则集
+    ruleSet = IgnoreRules();
+    for (const QString &rule : filterRules) {
+        ruleSet.addLine(rule.trimmed());
+    }
 }
 
 void FileMerger::setHeaderTemplate(const QString &headerTemplate)
@@ -67,6 +97,16 @@ void FileMerger::setExtractionRule(const QString &regex, bool enabled)
     useExtraction = enabled;
 }
 
+void FileMerger::setDeduplicateHardLinks(bool enabled)
+{
+    deduplicateHardLinks = enabled;
+}
+
+void FileMerger::setIgnoreFilesEnabled(bool enabled)
+{
+    ignoreFilesEnabled = enabled;
+}
+
 void FileMerger::startMerging()
 {
     if (rootPath.isEmpty()) {
@@ -75,14 +115,27 @@ void FileMerger::startMerging()
     }
 
     // 清空之前的结果
+    foundTree.reset(rootPath, QDir(rootPath).dirName());
     foundFiles.clear();
+    fileMetadata.clear();
     mergedText.clear();
+    ignoreStacks.reset(FileFilterUtil::normalizePath(rootPath, FileFilterUtil::EntryKind::Directory), true);
     isCancelled = false;
+    progressTracker->start();
     
     // 在后台线程中执行搜索和合并
     QFuture<void> future = QtConcurrent::run([this]() {
-        // 首先搜索文件
-        searchFiles(rootPath, 0);
+        // 首先搜索文件：目录由并行遍历器读取，这里按确定的深度优先顺序收集结果
+        // 符号链接环和绑定挂载会让同一目录出现在多条路径上，由遍历器按收集顺序判定重复，每个目录只搜索一次
+        DirectoryWalker walker(
+            [this](const QString &path, int depth, quint8, QVector<DirectoryWalker::Entry> &entries,
+                   DirectoryScanner::FileId &directoryId) {
+                listDirectory(path, depth, entries, directoryId);
+            },
+            [this]() { return isCancelled.load(); });
+        walker.setMaxDepth(maxDepth);
+        walker.setDeduplicateFiles(deduplicateHardLinks);
+        searchFiles(walker, walker.start(rootPath, 0), 0);
         
         // 然后合并文件内容
         if (!isCancelled && !foundFiles.isEmpty()) {
@@ -130,86 +183,131 @@ bool FileMerger::exportToFile(const QString &filePath) const
     return true;
 }
 
-void FileMerger::searchFiles(const QString &path, int currentDepth)
+void FileMerger::searchFiles(DirectoryWalker &walker, int slot, int node)
 {
-    if (isCancelled || currentDepth > maxDepth) {
+    if (isCancelled) {
         return;
     }
 
-    QDir dir(path);
-    QFileInfoList entries = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
+    // 本目录的条目先连续追加为子节点，再按原先的递归顺序收集：按条目顺序收集文件，遇到目录立即深入
+    const QVector<DirectoryWalker::Entry> entries = walker.take(slot);
+    const int firstChild = foundTree.nodeCount();
+    for (const DirectoryWalker::Entry &entry : entries) {
+        foundTree.appendChild(node, entry.name, entry.isDir);
+    }
     
-    for (const QFileInfo &info : entries) {
+    for (int i = 0; i < entries.size(); ++i) {
         if (isCancelled) {
             return;
         }
         
-        QString entryPath = info.filePath();
-        
-        if (info.isDir()) {
+        const DirectoryWalker::Entry &entry = entries.at(i);
+        if (entry.isDir) {
             // 递归处理子目录
-            searchFiles(entryPath, currentDepth + 1);
-        } else if (info.isFile()) {
-            // 检查文件是否匹配过滤模式
-            if (shouldIncludeFile(info.fileName(), entryPath)) {
-                foundFiles.append(entryPath);
-                emit processingFile(entryPath);
+            if (entry.slot >= 0) {
+                searchFiles(walker, entry.slot, firstChild + i);
             }
+        } else {
+            foundFiles.append(firstChild + i);
+            emit processingFile(foundTree.filePath(firstChild + i));
         }
     }
 }
 
-bool FileMerger::shouldIncludeFile(const QString &fileName, const QString &filePath) const
+QStringList FileMerger::foundFilePaths(int from, int count) const
 {
-    // 如果没有设置过滤模式和规则，则包含所有文件
-    if (fileFilter.isEmpty() && filterRules.isEmpty()) {
-        return true;
+    QStringList paths;
+    paths.reserve(count);
+    for (int i = from; i < from + count && i < foundFiles.size(); ++i) {
+        paths.append(foundTree.filePath(foundFiles.at(i)));
     }
+    return paths;
+}
+
+void FileMerger::listDirectory(const QString &path, int currentDepth, QVector<DirectoryWalker::Entry> &result,
+                               DirectoryScanner::FileId &directoryId)
+{
+    Q_UNUSED(currentDepth);
     
-    // 首先检查文件是否匹配过滤模式
-    bool matchesPattern = true;
-    if (!fileFilter.isEmpty()) {
-        if (!useRegex) {
-            // 使用通配符匹配
-            QRegularExpression wildcard(QRegularExpression::wildcardToRegularExpression(fileFilter));
-            matchesPattern = wildcard.match(fileName).hasMatch();
-        } else {
-            // 使用正则表达式匹配
-            QRegularExpression regex(fileFilter);
-            matchesPattern = regex.match(fileName).hasMatch();
-        }
+    // 条目类型直接来自目录项，无需对每个条目调用stat
+    QVector<DirectoryScanner::Entry> entries;
+    QStringList ignoreFiles;
+    if (!DirectoryScanner::scan(path, true, entries, nullptr, &directoryId, false,
+                                ignoreFilesEnabled ? &ignoreFiles : nullptr)) {
+        return;
     }
+    result.reserve(entries.size());
     
-    // 如果没有设置过滤规则，则只根据过滤模式判断
-    if (filterRules.isEmpty()) {
-        return matchesPattern;
+    // 本目录的忽略文件压入继承的规则栈，子目录搜索时直接共享，不再解析
+    QSharedPointer<const IgnoreStack> ignoreStack;
+    QString directory;
+    if (ignoreFilesEnabled) {
+        directory = FileFilterUtil::normalizePath(path, FileFilterUtil::EntryKind::Directory);
+        ignoreStack = ignoreStacks.enter(directory, ignoreFiles);
     }
     
-    // 如果设置了过滤规则，则检查是否匹配任一规则
-    for (const QString &rule : filterRules) {
-        QString trimmedRule = rule.trimmed();
-        if (trimmedRule.isEmpty() || trimmedRule.startsWith(QChar('#'))) {
-            continue; // 跳过空行和注释
-        }
-        
-        // 处理目录规则
-        bool isDir = trimmedRule.endsWith('/');
-        if (isDir) {
-            trimmedRule.chop(1);
+    // 文件路径和忽略规则用的规范化路径各用一个缓冲区，逐条目过滤时不分配内存
+    QString filePath;
+    filePath.reserve(path.size() + MaxNameLength + 1);
+    filePath += path;
+    if (!filePath.endsWith('/')) {
+        filePath += '/';
+    }
+    const qsizetype directoryLength = filePath.size();
+    QString ignorePath;
+    if (ignoreStack) {
+        ignorePath.reserve(directory.size() + MaxNameLength + 1);
+        ignorePath += directory;
+    }
+    
+    for (const DirectoryScanner::Entry &entry : entries) {
+        if (isCancelled) {
+            return;
         }
         
-        // 将gitignore风格的规则转换为通配符
-        QString pattern = trimmedRule;
-        if (pattern.startsWith(QStringLiteral("**/"))) {
-            pattern.remove(0, 3); // 移除 **/ 前缀
+        // 被忽略的目录不放入结果，遍历器不会打开它
+        if (ignoreStack) {
+            const FileFilterUtil::EntryKind kind = entry.isDir() ? FileFilterUtil::EntryKind::Directory
+                                                                 : FileFilterUtil::EntryKind::File;
+            FileFilterUtil::replaceChildName(ignorePath, directory.size(), entry.name, kind);
+            if (ignoreStack->isIgnored(ignorePath, entry.isDir())) {
+                continue;
+            }
         }
         
-        // 转换为正则表达式
-        QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(pattern));
-        if (regex.match(filePath).hasMatch() || regex.match(fileName).hasMatch()) {
-            return true; // 匹配到包含规则
+        if (entry.isDir()) {
+            result.append(DirectoryWalker::Entry(entry.name, true));
+        } else {
+            // 检查文件是否匹配过滤模式，硬链接由遍历器按收集顺序合并
+            filePath.truncate(directoryLength);
+            filePath += entry.name;
+            if (shouldIncludeFile(entry.name, filePath)) {
+                DirectoryWalker::Entry kept(entry.name, false);
+                kept.id = entry.id;
+                result.append(kept);
+            }
         }
     }
+}
+
+bool FileMerger::shouldIncludeFile(const QString &fileName, const QString &filePath) const
+{
+    // 如果没有设置过滤模式和规则，则包含所有文件
+    if (fileFilter.isEmpty() && filterRules.isEmpty()) {
+        return true;
+    }
+    
+    // 首先检查文件是否匹配过滤模式
+    const bool matchesPattern = fileFilter.isEmpty() || fileFilterExpression.matchView(fileName).hasMatch();
+    
+    // 如果设置了过滤规则，则检查文件或它所在的目录是否匹配规则
+    QStringView relativePath = QStringView(filePath).mid(rootPath.size());
+    if (relativePath.startsWith('/')) {
+        relativePath = relativePath.mid(1);
+    }
+    if (ruleSet.matchesWithParents(relativePath, false)) {
+        return true; // 匹配到包含规则
+    }
     
     // 如果有过滤规则但都不匹配，则根据过滤模式判断
     return matchesPattern;
@@ -222,44 +320,72 @@ void FileMerger::mergeFiles()
         return;
     }
     
+    // 分批批量获取所有文件的元数据，文件大小之和作为进度的总量，文件头模板也复用这些元数据
+    fileMetadata.clear();
+    fileMetadata.reserve(totalFiles);
+    for (int batchStart = 0; batchStart < totalFiles; batchStart += MetadataBatchSize) {
+        QVector<DirectoryScanner::Metadata> batchMetadata;
+        FileMetadataCollector::collect(foundFilePaths(batchStart, MetadataBatchSize), batchMetadata);
+        fileMetadata.append(batchMetadata);
+    }
+    qint64 totalBytes = 0;
+    for (const DirectoryScanner::Metadata &metadata : fileMetadata) {
+        totalBytes += metadata.size;
+    }
+    progressTracker->addTotal(totalBytes);
+    
     QStringList contentList;
     
-    for (int i = 0; i < totalFiles; ++i) {
-        if (isCancelled) {
-            return;
-        }
+    for (int batchStart = 0; batchStart < totalFiles; batchStart += OpenBatchSize) {
+        // 按批次打开文件，io_uring不可用时fds全部为-1，逐个按路径打开
+        const QStringList batchPaths = foundFilePaths(batchStart, OpenBatchSize);
+        const QVector<int> fds = FileMetadataCollector::openFiles(batchPaths);
         
-        QString filePath = foundFiles.at(i);
-        QFile file(filePath);
-        
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream in(&file);
-            QString content = in.readAll();
-            file.close();
-            
-            // 如果启用了内容提取，则提取指定内容
-            if (useExtraction && !extractionRegex.isEmpty()) {
-                content = extractContent(content);
+        for (int j = 0; j < batchPaths.size(); ++j) {
+            if (isCancelled) {
+                FileMetadataCollector::closeFiles(fds, j);
+                return;
             }
             
-            // 生成文件头
-            QString header = generateHeader(filePath, i + 1);
-            
-            // 添加到内容列表
-            if (!header.isEmpty()) {
-                contentList.append(header);
+            const int i = batchStart + j;
+            const QString &filePath = batchPaths.at(j);
+            QFile file;
+            bool opened = false;
+            if (fds.at(j) >= 0) {
+                opened = file.open(fds.at(j), QIODevice::ReadOnly | QIODevice::Text, QFileDevice::AutoCloseHandle);
+            } else {
+                file.setFileName(filePath);
+                opened = file.open(QIODevice::ReadOnly | QIODevice::Text);
             }
-            contentList.append(content);
             
-            // 添加分隔符（如果不是最后一个文件）
-            if (useSeparator && i < totalFiles - 1) {
-                contentList.append(separator);
+            if (opened) {
+                QTextStream in(&file);
+                QString content = in.readAll();
+                file.close();
+                
+                // 如果启用了内容提取，则提取指定内容
+                if (useExtraction && !extractionRegex.isEmpty()) {
+                    content = extractContent(content);
+                }
+                
+                // 生成文件头
+                QString header = generateHeader(filePath, i + 1);
+                
+                // 添加到内容列表
+                if (!header.isEmpty()) {
+                    contentList.append(header);
+                }
+                contentList.append(content);
+                
+                // 添加分隔符（如果不是最后一个文件）
+                if (useSeparator && i < totalFiles - 1) {
+                    contentList.append(separator);
+                }
             }
+            
+            // 更新进度，按预计大小计入，保证全部完成时恰好达到总量
+            progressTracker->addCompleted(fileMetadata.at(i).size);
         }
-        
-        // 更新进度
-        int progressValue = ((i + 1) * 100) / totalFiles;
-        emit progressUpdated(progressValue);
     }
     
     // 合并所有内容
@@ -294,6 +420,7 @@ QString FileMerger::generateHeader(const QString &filePath, int index) const
         return QString();
     }
     
+    // QFileInfo只用于拆分路径字符串，不会访问文件系统
     QFileInfo fileInfo(filePath);
     QString header = headerTemplate;
     
@@ -303,9 +430,20 @@ QString FileMerger::generateHeader(const QString &filePath, int index) const
     header.replace("{path}", filePath);
     header.replace("{basename}", fileInfo.baseName());
     header.replace("{suffix}", fileInfo.suffix());
-    header.replace("{size}", QString::number(fileInfo.size()));
-    header.replace("{date}", fileInfo.lastModified().toString("yyyy-MM-dd"));
-    header.replace("{time}", fileInfo.lastModified().toString("HH:mm:ss"));
+    
+    // 只有模板确实用到大小或时间时才查询元数据
+    if (header.contains("{size}") || header.contains("{date}") || header.contains("{time}")) {
+        // 优先使用mergeFiles()批量预取的结果
+        DirectoryScanner::Metadata metadata;
+        if (index >= 1 && index <= fileMetadata.size()) {
+            metadata = fileMetadata.at(index - 1);
+        } else {
+            DirectoryScanner::queryMetadata(filePath, metadata);
+        }
+        header.replace("{size}", QString::number(metadata.size));
+        header.replace("{date}", metadata.lastModified.toString("yyyy-MM-dd"));
+        header.replace("{time}", metadata.lastModified.toString("HH:mm:ss"));
+    }
     
     return header;
-} 
\ No newline at end of file
+} 
@@ -224,9 +224,10 @@ void FileMergerWidget::cancelMerging()
     cancelButton->setEnabled(false);
 }
 
-void FileMergerWidget::updateProgress(int value)
+void FileMergerWidget::updateProgress(int value, const QString &detail)
 {
     progressBar->setValue(value);
+    statusLabel->setText(tr("正在合并文件... ") + detail);
 }
 
 void FileMergerWidget::mergeFinished()
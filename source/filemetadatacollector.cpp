@@ -0,0 +1,368 @@
+#include "filemetadatacollector.h"
+
+#include <QFile>
+#include <QtConcurrent/QtConcurrent>
+
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+// 每个批次提交的最大请求数
+const unsigned RingEntries = 256;
+
+/**
+ * @brief 直接基于系统调用的最小io_uring封装
+ *
+ * 只实现批量提交statx/openat并等待全部完成所需的部分，不依赖liburing。
+ */
+class UringQueue
+{
+public:
+    UringQueue()
+        : ringFd(-1), sqRing(nullptr), cqRing(nullptr), sqes(nullptr)
+        , sqRingSize(0), cqRingSize(0), sqesSize(0)
+        , sqTail(nullptr), sqMask(nullptr), sqArray(nullptr), sqEntries(0)
+        , cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr)
+        , localTail(0)
+    {
+    }
+
+    ~UringQueue()
+    {
+        if (sqes) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (ringFd >= 0) {
+            close(ringFd);
+        }
+    }
+
+    UringQueue(const UringQueue &) = delete;
+    UringQueue &operator=(const UringQueue &) = delete;
+
+    // 创建并映射队列，失败（内核不支持或被禁用）时返回false
+    bool init(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqRingSize = cqRingSize = qMax(sqRingSize, cqRingSize);
+        }
+
+        void *sq = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringFd, IORING_OFF_SQ_RING);
+        if (sq == MAP_FAILED) {
+            return false;
+        }
+        sqRing = static_cast<char *>(sq);
+
+        if (singleMmap) {
+            cqRing = sqRing;
+        } else {
+            void *cq = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ringFd, IORING_OFF_CQ_RING);
+            if (cq == MAP_FAILED) {
+                return false;
+            }
+            cqRing = static_cast<char *>(cq);
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               ringFd, IORING_OFF_SQES);
+        if (sqeMemory == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe *>(sqeMemory);
+
+        sqTail = reinterpret_cast<unsigned *>(sqRing + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned *>(sqRing + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sqRing + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        cqHead = reinterpret_cast<unsigned *>(cqRing + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cqRing + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned *>(cqRing + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cqRing + params.cq_off.cqes);
+        localTail = *sqTail;
+        return true;
+    }
+
+    // 检查内核是否支持statx和openat操作
+    bool supportsRequiredOps() const
+    {
+        const size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+        std::vector<char> buffer(probeSize, 0);
+        io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+
+        auto supported = [probe](int op) {
+            return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        };
+        return supported(IORING_OP_STATX) && supported(IORING_OP_OPENAT);
+    }
+
+    unsigned capacity() const
+    {
+        return sqEntries;
+    }
+
+    void prepareStatx(const char *path, struct statx *buffer, quint64 userData)
+    {
+        io_uring_sqe *sqe = nextSqe();
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<quint64>(path);
+        sqe->len = STATX_SIZE | STATX_MTIME;
+        sqe->off = reinterpret_cast<quint64>(buffer);
+        sqe->statx_flags = 0;
+        sqe->user_data = userData;
+    }
+
+    void prepareOpenat(const char *path, quint64 userData)
+    {
+        io_uring_sqe *sqe = nextSqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<quint64>(path);
+        sqe->len = 0;
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = userData;
+    }
+
+    // 提交已准备的count个请求并等待它们全部完成，每个完成项调用一次onComplete(userData, result)；
+    // 出错时撤回尚未提交的请求、等待已提交的请求全部完成后返回false，没有收到完成项的请求由调用方另行处理
+    template <typename Callback>
+    bool submitAndWait(unsigned count, Callback onComplete)
+    {
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+
+        unsigned toSubmit = count;
+        unsigned completed = 0;
+        while (completed < count) {
+            const long ret = syscall(__NR_io_uring_enter, ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0) {
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    // 内核只在io_uring_enter中读取提交队列，撤回的请求不会再被执行
+                    localTail -= toSubmit;
+                    __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+                    drain(count - toSubmit - completed, onComplete);
+                    return false;
+                }
+            } else {
+                toSubmit -= qMin(toSubmit, static_cast<unsigned>(ret));
+            }
+            completed += reap(onComplete);
+        }
+        return true;
+    }
+
+private:
+    int ringFd;
+    char *sqRing;
+    char *cqRing;
+    io_uring_sqe *sqes;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqesSize;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned sqEntries;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    io_uring_cqe *cqes;
+    unsigned localTail;
+
+    io_uring_sqe *nextSqe()
+    {
+        const unsigned index = localTail & *sqMask;
+        io_uring_sqe *sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        ++localTail;
+        return sqe;
+    }
+
+    // 等待已提交的inFlight个请求完成，请求完成前它们引用的路径和缓冲区必须保持有效
+    template <typename Callback>
+    void drain(unsigned inFlight, Callback &onComplete)
+    {
+        while (inFlight > 0) {
+            if (syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+                // 连等待也失败时改为轮询完成队列
+                sched_yield();
+            }
+            inFlight -= reap(onComplete);
+        }
+    }
+
+    template <typename Callback>
+    unsigned reap(Callback &onComplete)
+    {
+        unsigned head = *cqHead;
+        const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        while (head != tail) {
+            const io_uring_cqe &cqe = cqes[head & *cqMask];
+            onComplete(cqe.user_data, cqe.res);
+            ++head;
+            ++count;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+};
+
+QDateTime toDateTime(const statx_timestamp &timestamp)
+{
+    return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(timestamp.tv_sec) * 1000 + timestamp.tv_nsec / 1000000);
+}
+}
+#endif
+
+bool FileMetadataCollector::isUringAvailable()
+{
+#ifdef Q_OS_LINUX
+    static const bool available = []() {
+        UringQueue queue;
+        return queue.init(8) && queue.supportsRequiredOps();
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+QVector<bool> FileMetadataCollector::collect(const QStringList &paths, QVector<DirectoryScanner::Metadata> &metadata)
+{
+    const int count = paths.size();
+    metadata.fill(DirectoryScanner::Metadata(), count);
+    QVector<bool> ok(count, false);
+    QVector<bool> handled(count, false);
+
+#ifdef Q_OS_LINUX
+    // 缓冲区先于队列构造，队列析构（关闭io_uring）时它们仍然有效
+    std::vector<QByteArray> encodedPaths;
+    std::vector<struct statx> buffers;
+    UringQueue queue;
+    if (isUringAvailable() && queue.init(RingEntries)) {
+        const int batchSize = static_cast<int>(queue.capacity());
+        encodedPaths.resize(batchSize);
+        buffers.resize(batchSize);
+
+        bool submitted = true;
+        for (int start = 0; start < count && submitted; start += batchSize) {
+            const int batchCount = qMin(batchSize, count - start);
+            for (int i = 0; i < batchCount; ++i) {
+                encodedPaths[i] = QFile::encodeName(paths.at(start + i));
+                queue.prepareStatx(encodedPaths[i].constData(), &buffers[i], static_cast<quint64>(i));
+            }
+
+            submitted = queue.submitAndWait(batchCount, [&](quint64 userData, int result) {
+                const int index = start + static_cast<int>(userData);
+                handled[index] = true;
+                if (result < 0) {
+                    return;
+                }
+                const struct statx &stx = buffers[userData];
+                metadata[index].size = static_cast<qint64>(stx.stx_size);
+                metadata[index].lastModified = toDateTime(stx.stx_mtime);
+                ok[index] = true;
+            });
+        }
+        if (submitted) {
+            return ok;
+        }
+    }
+#endif
+
+    // 回退：在线程池中并行查询，io_uring中途出错时只处理没有收到完成项的文件
+    DirectoryScanner::Metadata *metadataOut = metadata.data();
+    bool *okOut = ok.data();
+    QVector<int> indices;
+    indices.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        if (!handled.at(i)) {
+            indices.append(i);
+        }
+    }
+    QtConcurrent::blockingMap(indices, [&paths, metadataOut, okOut](int index) {
+        okOut[index] = DirectoryScanner::queryMetadata(paths.at(index), metadataOut[index]);
+    });
+    return ok;
+}
+
+QVector<int> FileMetadataCollector::openFiles(const QStringList &paths)
+{
+    const int count = paths.size();
+    QVector<int> fds(count, -1);
+
+#ifdef Q_OS_LINUX
+    // 路径缓冲区先于队列构造，队列析构时它仍然有效
+    std::vector<QByteArray> encodedPaths;
+    UringQueue queue;
+    if (!isUringAvailable() || !queue.init(RingEntries)) {
+        return fds;
+    }
+
+    const int batchSize = static_cast<int>(queue.capacity());
+    encodedPaths.resize(batchSize);
+    for (int start = 0; start < count; start += batchSize) {
+        const int batchCount = qMin(batchSize, count - start);
+        for (int i = 0; i < batchCount; ++i) {
+            encodedPaths[i] = QFile::encodeName(paths.at(start + i));
+            queue.prepareOpenat(encodedPaths[i].constData(), static_cast<quint64>(i));
+        }
+
+        const bool submitted = queue.submitAndWait(batchCount, [&](quint64 userData, int result) {
+            fds[start + static_cast<int>(userData)] = result >= 0 ? result : -1;
+        });
+        if (!submitted) {
+            break;
+        }
+    }
+#endif
+
+    return fds;
+}
+
+void FileMetadataCollector::closeFiles(const QVector<int> &fds, int from)
+{
+#ifdef Q_OS_LINUX
+    for (int i = qMax(0, from); i < fds.size(); ++i) {
+        if (fds.at(i) >= 0) {
+            close(fds.at(i));
+        }
+    }
+#else
+    Q_UNUSED(fds);
+    Q_UNUSED(from);
+#endif
+}
@@ -0,0 +1,418 @@
+#include "filtermatcher.h"
+#include "filtertrace.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QStringView>
+#include <QVarLengthArray>
+
+namespace {
+// 折叠大小写后的路径，常见长度的路径不需要分配内存
+using FoldedPath = QVarLengthArray<char16_t, 256>;
+
+QStringView foldPath(const QString &path, FoldedPath &buffer)
+{
+    buffer.resize(path.size());
+    LiteralSet::foldCase(QStringView(path).utf16(), path.size(), buffer.data());
+    return QStringView(buffer.constData(), buffer.size());
+}
+
+// 记录一次查找
+void recordLookup(std::atomic<quint64> &lookups, std::atomic<quint64> &nanoseconds, qint64 elapsed)
+{
+    lookups.fetch_add(1, std::memory_order_relaxed);
+    nanoseconds.fetch_add(static_cast<quint64>(elapsed), std::memory_order_relaxed);
+}
+}
+
+FilterMatcher::FilterMatcher(const QList<FileFilterUtil::FilterRule> &rules)
+    : fileTypeIncludeRule(false)
+    , buildIncludeRule(false)
+    , ruleCount(static_cast<int>(rules.size()))
+    , ruleCounters(new RuleCounter[rules.size()])
+{
+    for (int i = 0; i < rules.size(); ++i) {
+        const FileFilterUtil::FilterRule &rule = rules.at(i);
+        if (!rule.enabled) {
+            continue;
+        }
+
+        const bool include = rule.filterMode == FileFilterUtil::FilterMode::Include;
+        if (rule.matchType == FileFilterUtil::MatchType::Gitignore) {
+            // 包含模式的gitignore规则等同于以!开头，重新包含之前被忽略的路径
+            if (ignoreRules.addLine(rule.pattern, i, include)) {
+                ruleCounters[i].group = &ignoreCounter;
+                ruleCounters[i].indexed = true;
+                ++ignoreCounter.ruleCount;
+                if (include != rule.pattern.startsWith('!') && rule.pattern.contains("build", Qt::CaseInsensitive)) {
+                    buildIncludeRule = true;
+                }
+            }
+            continue;
+        }
+
+        const CompiledRule compiled = compile(rule, i);
+        if (include) {
+            if (rule.pattern.startsWith("*.") || (rule.pattern.contains('.') && !compiled.pathRule)) {
+                fileTypeIncludeRule = true;
+            }
+            if (rule.pattern.contains("build", Qt::CaseInsensitive)) {
+                buildIncludeRule = true;
+            }
+        }
+
+        RuleSet &set = include ? includeRules : excludeRules;
+        ruleCounters[i].group = &set.counter;
+        ruleCounters[i].indexed = addRule(set, compiled);
+        if (ruleCounters[i].indexed) {
+            ++set.counter.ruleCount;
+        }
+        if (!include) {
+            excludeDirectories.add(compiled.directoryNeedle, i, true);
+        }
+    }
+
+    includeRules.substrings.build();
+    excludeRules.substrings.build();
+    excludeDirectories.build();
+}
+
+FilterMatcher::CompiledRule FilterMatcher::compile(const FileFilterUtil::FilterRule &rule, int index)
+{
+    CompiledRule compiled;
+    compiled.index = index;
+
+    QString normalized = rule.pattern;
+    normalized.replace('\\', '/');
+    compiled.trailingSeparator = normalized.endsWith('/');
+    compiled.directoryRule = compiled.trailingSeparator || normalized == "build";
+    compiled.directoryName = compiled.trailingSeparator ? normalized.left(normalized.length() - 1) : normalized;
+    compiled.directoryNeedle = "/" + compiled.directoryName + "/";
+    compiled.directorySuffix = "/" + compiled.directoryName;
+    compiled.pathRule = normalized.contains('/');
+    compiled.relativePath = compiled.pathRule
+        && (compiled.directoryName.startsWith('/') || compiled.directoryName.startsWith("./")
+            || compiled.directoryName.startsWith("../"));
+
+    // 扩展名规则和不含分隔符的包含规则不针对目录，目录默认被包含
+    compiled.includesDirectories = rule.filterMode == FileFilterUtil::FilterMode::Include
+        && (rule.pattern.startsWith("*.") || rule.pattern.startsWith(".") || !compiled.pathRule);
+
+    const QString &pattern = rule.pattern;
+    if (rule.matchType == FileFilterUtil::MatchType::Regex) {
+        compiled.kind = Kind::Expression;
+        compiled.expression = QRegularExpression(pattern, QRegularExpression::CaseInsensitiveOption);
+    } else if (pattern == "*") {
+        compiled.kind = Kind::All;
+    } else if (pattern.startsWith('*') && pattern.endsWith('*')) {
+        compiled.kind = Kind::Contains;
+        compiled.literal = pattern.mid(1, pattern.length() - 2);
+    } else if (pattern.startsWith('*')) {
+        compiled.kind = Kind::Suffix;
+        compiled.literal = pattern.mid(1);
+    } else if (pattern.endsWith('*')) {
+        compiled.kind = Kind::Prefix;
+        compiled.literal = pattern.left(pattern.length() - 1);
+    } else if (pattern.contains('*')) {
+        QString expression = QRegularExpression::escape(pattern);
+        expression.replace("\\*", ".*");
+        compiled.kind = Kind::Expression;
+        compiled.expression = QRegularExpression(expression, QRegularExpression::CaseInsensitiveOption);
+    } else {
+        compiled.kind = Kind::Exact;
+        compiled.literal = pattern;
+    }
+
+    // 立即编译（含JIT），之后多个线程可以同时使用同一个表达式匹配
+    if (compiled.kind == Kind::Expression) {
+        compiled.expression.optimize();
+        if (!compiled.expression.isValid()) {
+            qWarning() << "无效的过滤规则:" << pattern << compiled.expression.errorString();
+        }
+    }
+    return compiled;
+}
+
+bool FilterMatcher::addRule(RuleSet &set, const CompiledRule &rule)
+{
+    set.isEmpty = false;
+    bool indexed = rule.kind != Kind::Expression;
+    if (rule.includesDirectories && set.directoryRule < 0) {
+        set.directoryRule = rule.index;
+        indexed = true;
+    }
+
+    // 目录规则：路径中包含该目录；以分隔符结尾的路径模式对文件也生效，并且可以位于路径末尾
+    if (rule.pathRule && rule.trailingSeparator) {
+        set.substrings.add(rule.directoryNeedle, rule.index, false);
+        set.suffixes.insert(rule.directorySuffix, rule.index);
+        indexed = true;
+    } else if (rule.directoryRule) {
+        set.substrings.add(rule.directoryNeedle, rule.index, true);
+        indexed = true;
+    }
+    if (rule.pathRule && rule.relativePath) {
+        set.substrings.add(rule.directoryName, rule.index, false);
+        indexed = true;
+    }
+
+    switch (rule.kind) {
+    case Kind::All:
+        if (set.allRule < 0) {
+            set.allRule = rule.index;
+        }
+        break;
+    case Kind::Contains:
+        set.substrings.add(rule.literal, rule.index, false);
+        break;
+    case Kind::Suffix:
+        set.suffixes.insert(rule.literal, rule.index);
+        break;
+    case Kind::Prefix:
+        set.prefixes.insert(rule.literal, rule.index);
+        break;
+    case Kind::Exact:
+        set.exactPaths.insert(rule.literal, rule.index);
+        break;
+    case Kind::Expression:
+        set.expressions.append(rule);
+        break;
+    }
+    return indexed;
+}
+
+bool FilterMatcher::shouldInclude(const QString &path, int relativeStart, FileFilterUtil::EntryKind kind,
+                                  FileFilterUtil::DirectoryVerdict verdict) const
+{
+    if (verdict == FileFilterUtil::DirectoryVerdict::ExcludeAll) {
+        return false;
+    }
+
+    const bool isDirectory = kind == FileFilterUtil::EntryKind::Directory;
+    QStringView relativePath = QStringView(path).mid(relativeStart);
+    if (relativePath.endsWith('/')) {
+        relativePath.chop(1);
+    }
+    if (relativePath.startsWith('/')) {
+        relativePath = relativePath.mid(1);
+    }
+
+    // 没有包含规则提到build时，build目录自动排除
+    if (isDirectory && !buildIncludeRule) {
+        const QStringView name = relativePath.mid(relativePath.lastIndexOf('/') + 1);
+        if (name.compare(QLatin1String("build"), Qt::CaseInsensitive) == 0
+            || path.contains(QLatin1String("/build/"), Qt::CaseInsensitive)) {
+            FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::BuildExcluded, path, -1);
+            return false;
+        }
+    }
+    if (verdict == FileFilterUtil::DirectoryVerdict::IncludeAll) {
+        return true;
+    }
+
+    // gitignore规则忽略的条目直接排除，目录连同子树一起剪掉
+    const bool profiling = FileFilterUtil::isProfilingEnabled();
+    int source = -1;
+    IgnoreRules::Verdict ignoreVerdict;
+    if (profiling && ignoreCounter.ruleCount > 0) {
+        QElapsedTimer timer;
+        timer.start();
+        ignoreVerdict = ignoreRules.match(relativePath, isDirectory, &source);
+        recordLookup(ignoreCounter.lookups, ignoreCounter.nanoseconds, timer.nsecsElapsed());
+        if (ignoreVerdict != IgnoreRules::Verdict::Unmatched && source >= 0) {
+            ruleCounters[source].hits.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        ignoreVerdict = ignoreRules.match(relativePath, isDirectory, &source);
+    }
+    if (ignoreVerdict == IgnoreRules::Verdict::Matched) {
+        FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::IgnoreMatched, path, source);
+        return false;
+    }
+
+    if (includeRules.isEmpty && excludeRules.isEmpty) {
+        return true;
+    }
+
+    // 路径只折叠一次大小写，之后各类索引都直接比较；缓冲区按线程复用，超长路径也只在第一次分配
+    thread_local FoldedPath buffer;
+    const QStringView folded = foldPath(path, buffer);
+
+    if (matchesRules(path, folded, isDirectory, profiling)) {
+        return true;
+    }
+
+    // 有文件类型包含规则(如*.cpp)时，没有被明确排除的目录仍需遍历；
+    // 目录路径以'/'结尾，"/名称/"同时覆盖了目录名本身
+    if (isDirectory && fileTypeIncludeRule && excludeDirectories.find(folded, true) < 0) {
+        FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::DirectoryTraversed, path, -1);
+        return true;
+    }
+    return false;
+}
+
+FileFilterUtil::DirectoryVerdict FilterMatcher::directoryVerdict(const QString &path,
+                                                                 FileFilterUtil::DirectoryVerdict inherited) const
+{
+    using Verdict = FileFilterUtil::DirectoryVerdict;
+    if (inherited != Verdict::TestEntries) {
+        return inherited;
+    }
+
+    const bool canIgnore = ignoreRules.canIgnore();
+    if (includeRules.isEmpty && excludeRules.isEmpty) {
+        return canIgnore ? Verdict::TestEntries : Verdict::IncludeAll;
+    }
+
+    // 子串和前缀已经出现在目录路径中时，子树中每个路径都包含它们
+    FoldedPath buffer;
+    const QStringView folded = foldPath(path, buffer);
+    const auto matchesSubtree = [folded](const RuleSet &set) {
+        return set.allRule >= 0 || set.substrings.find(folded, false) >= 0 || set.prefixes.findPrefix(folded) >= 0;
+    };
+
+    // 包含规则先于排除规则检查，但在build目录和gitignore规则之后
+    if (!includeRules.isEmpty) {
+        if (!canIgnore && matchesSubtree(includeRules)) {
+            FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::SubtreeIncluded, path, -1);
+            return Verdict::IncludeAll;
+        }
+        return Verdict::TestEntries;
+    }
+
+    // 没有包含规则时，匹配排除规则的条目一定被排除，目录也不会因文件类型规则保留
+    if (matchesSubtree(excludeRules)) {
+        FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::SubtreeExcluded, path, -1);
+        return Verdict::ExcludeAll;
+    }
+    return Verdict::TestEntries;
+}
+
+bool FilterMatcher::matchesRules(const QString &path, QStringView folded, bool isDirectory, bool profiling) const
+{
+    // 匹配到包含规则，直接包含
+    const int includeRule = profiling ? profileRule(includeRules, path, folded, isDirectory)
+                                      : findRule(includeRules, path, folded, isDirectory);
+    if (includeRule >= 0) {
+        FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::IncludeMatched, path, includeRule);
+        return true;
+    }
+
+    // 如果有包含规则但都不匹配，则默认排除；存在文件类型包含规则时仍允许遍历目录
+    const bool shouldInclude = includeRules.isEmpty;
+    if (!shouldInclude && isDirectory && fileTypeIncludeRule) {
+        FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::DirectoryTraversed, path, -1);
+        return true;
+    }
+
+    // 匹配到排除规则，直接排除
+    const int excludeRule = profiling ? profileRule(excludeRules, path, folded, isDirectory)
+                                      : findRule(excludeRules, path, folded, isDirectory);
+    if (excludeRule >= 0) {
+        FILTER_TRACE(FilterTrace::Rules, FilterTrace::Event::ExcludeMatched, path, excludeRule);
+        return false;
+    }
+
+    FILTER_TRACE(FilterTrace::Rules,
+                 shouldInclude ? FilterTrace::Event::DefaultIncluded : FilterTrace::Event::DefaultExcluded,
+                 path, -1);
+    return shouldInclude;
+}
+
+int FilterMatcher::findRule(const RuleSet &set, const QString &path, QStringView folded, bool isDirectory)
+{
+    const int rule = findIndexedRule(set, folded, isDirectory);
+    if (rule >= 0) {
+        return rule;
+    }
+
+    for (const CompiledRule &expression : set.expressions) {
+        if (expression.expression.matchView(path).hasMatch()) {
+            return expression.index;
+        }
+    }
+    return -1;
+}
+
+int FilterMatcher::findIndexedRule(const RuleSet &set, QStringView folded, bool isDirectory)
+{
+    if (set.isEmpty) {
+        return -1;
+    }
+    if (set.allRule >= 0) {
+        return set.allRule;
+    }
+
+    // 扩展名规则和不针对目录的包含规则，目录默认被包含
+    if (isDirectory && set.directoryRule >= 0) {
+        return set.directoryRule;
+    }
+
+    // 每类索引只查一次，代价与其中的规则数量无关
+    int rule = set.substrings.find(folded, isDirectory);
+    if (rule < 0) {
+        rule = set.suffixes.findSuffix(folded);
+    }
+    if (rule < 0) {
+        rule = set.prefixes.findPrefix(folded);
+    }
+    if (rule < 0) {
+        rule = set.exactPaths.find(folded);
+    }
+    return rule;
+}
+
+int FilterMatcher::profileRule(const RuleSet &set, const QString &path, QStringView folded, bool isDirectory) const
+{
+    if (set.isEmpty) {
+        return -1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int rule = findIndexedRule(set, folded, isDirectory);
+    recordLookup(set.counter.lookups, set.counter.nanoseconds, timer.nsecsElapsed());
+
+    // 正则表达式各自计时，找出代价高的规则
+    for (int i = 0; rule < 0 && i < set.expressions.size(); ++i) {
+        const CompiledRule &expression = set.expressions.at(i);
+        RuleCounter &counter = ruleCounters[expression.index];
+        timer.restart();
+        const bool matched = expression.expression.matchView(path).hasMatch();
+        recordLookup(counter.evaluations, counter.nanoseconds, timer.nsecsElapsed());
+        if (matched) {
+            rule = expression.index;
+        }
+    }
+
+    if (rule >= 0) {
+        ruleCounters[rule].hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    return rule;
+}
+
+QVector<FileFilterUtil::RuleStatistics> FilterMatcher::statistics() const
+{
+    QVector<FileFilterUtil::RuleStatistics> result(ruleCount);
+    for (int i = 0; i < ruleCount; ++i) {
+        const RuleCounter &counter = ruleCounters[i];
+        if (!counter.group) {
+            continue;
+        }
+
+        // 放入索引的规则每次查找都参与，用时按组内规则数平分；正则表达式另计单独匹配的部分
+        quint64 evaluations = counter.evaluations.load(std::memory_order_relaxed);
+        quint64 nanoseconds = counter.nanoseconds.load(std::memory_order_relaxed);
+        if (counter.indexed) {
+            evaluations += counter.group->lookups.load(std::memory_order_relaxed);
+            nanoseconds += counter.group->nanoseconds.load(std::memory_order_relaxed)
+                / static_cast<quint64>(counter.group->ruleCount);
+        }
+
+        FileFilterUtil::RuleStatistics &statistics = result[i];
+        statistics.hits = counter.hits.load(std::memory_order_relaxed);
+        statistics.misses = evaluations > statistics.hits ? evaluations - statistics.hits : 0;
+        statistics.nanoseconds = nanoseconds;
+    }
+    return result;
+}
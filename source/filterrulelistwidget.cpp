@@ -37,9 +37,12 @@ void FilterRuleListWidget::setupUI()
     // 匹配类型选择
     wildcardRadioButton = new QRadioButton(QStringLiteral("通配符"), this);
     regexRadioButton = new QRadioButton(QStringLiteral("正则表达式"), this);
+    gitignoreRadioButton = new QRadioButton(QStringLiteral("gitignore"), this);
+    gitignoreRadioButton->setToolTip(QStringLiteral("按.gitignore语法匹配：支持!取反、/锚定、**和以/结尾的目录规则，与git一样区分大小写，排除的目录不再读取"));
     matchTypeGroup = new QButtonGroup(this);
     matchTypeGroup->addButton(wildcardRadioButton, static_cast<int>(FileFilterUtil::MatchType::Wildcard));
     matchTypeGroup->addButton(regexRadioButton, static_cast<int>(FileFilterUtil::MatchType::Regex));
+    matchTypeGroup->addButton(gitignoreRadioButton, static_cast<int>(FileFilterUtil::MatchType::Gitignore));
     wildcardRadioButton->setChecked(true);
     
     // 过滤模式选择
@@ -49,8 +52,11 @@ void FilterRuleListWidget::setupUI()
     filterModeCombo->addItem(QStringLiteral("排除"), static_cast<int>(FileFilterUtil::FilterMode::Exclude));
     filterModeCombo->setCurrentIndex(1); // 默认选择排除模式
     
-    inputLayout->addWidget(wildcardRadioButton, 1, 0);
-    inputLayout->addWidget(regexRadioButton, 1, 1);
+    QHBoxLayout *matchTypeLayout = new QHBoxLayout();
+    matchTypeLayout->addWidget(wildcardRadioButton);
+    matchTypeLayout->addWidget(regexRadioButton);
+    matchTypeLayout->addWidget(gitignoreRadioButton);
+    inputLayout->addLayout(matchTypeLayout, 1, 0, 1, 2);
     inputLayout->addWidget(filterModeLabel, 1, 2);
     inputLayout->addWidget(filterModeCombo, 1, 3);
     
@@ -94,6 +100,7 @@ void FilterRuleListWidget::createConnections()
 void FilterRuleListWidget::setFilterRules(const QList<FileFilterUtil::FilterRule> &rules)
 {
     m_rules = rules;
+    m_statistics.clear();
     updateRulesList();
 }
 
@@ -105,6 +112,7 @@ QList<FileFilterUtil::FilterRule> FilterRuleListWidget::getFilterRules() const
 void FilterRuleListWidget::clearRules()
 {
     m_rules.clear();
+    m_statistics.clear();
     updateRulesList();
     emit rulesChanged(m_rules);
 }
@@ -120,8 +128,10 @@ void FilterRuleListWidget::addRule()
     FileFilterUtil::MatchType matchType;
     if (wildcardRadioButton->isChecked()) {
         matchType = FileFilterUtil::MatchType::Wildcard;
-    } else {
+    } else if (regexRadioButton->isChecked()) {
         matchType = FileFilterUtil::MatchType::Regex;
+    } else {
+        matchType = FileFilterUtil::MatchType::Gitignore;
     }
     
     // 获取过滤模式
@@ -131,6 +141,7 @@ void FilterRuleListWidget::addRule()
     // 添加规则
     FileFilterUtil::FilterRule rule(pattern, matchType, filterMode, true);
     m_rules.append(rule);
+    m_statistics.clear();
     
     // 更新界面
     updateRulesList();
@@ -146,11 +157,18 @@ void FilterRuleListWidget::removeSelectedRule()
     int currentRow = rulesListWidget->currentRow();
     if (currentRow >= 0 && currentRow < m_rules.size()) {
         m_rules.removeAt(currentRow);
+        m_statistics.clear();
         updateRulesList();
         emit rulesChanged(m_rules);
     }
 }
 
+void FilterRuleListWidget::setRuleStatistics(const QVector<FileFilterUtil::RuleStatistics> &statistics)
+{
+    m_statistics = statistics.size() == m_rules.size() ? statistics : QVector<FileFilterUtil::RuleStatistics>();
+    updateRulesList();
+}
+
 void FilterRuleListWidget::openFilterRulesDialog()
 {
     FilterRulesDialog dialog(this);
@@ -158,6 +176,7 @@ void FilterRuleListWidget::openFilterRulesDialog()
     
     if (dialog.exec() == QDialog::Accepted) {
         m_rules = dialog.getFilterRules();
+        m_statistics.clear();
         updateRulesList();
         emit rulesChanged(m_rules);
     }
@@ -172,12 +191,23 @@ void FilterRuleListWidget::updateRulesList()
 {
     rulesListWidget->clear();
     
-    for (const FileFilterUtil::FilterRule &rule : m_rules) {
-        QListWidgetItem *item = new QListWidgetItem(generateRuleItemText(rule), rulesListWidget);
+    for (int i = 0; i < m_rules.size(); ++i) {
+        const FileFilterUtil::FilterRule &rule = m_rules.at(i);
+        QString text = generateRuleItemText(rule);
+        
+        // 有统计时在规则后面显示命中次数和用时，从未命中的规则用红色标出以便删除
+        const bool hasStatistics = rule.enabled && i < m_statistics.size();
+        if (hasStatistics) {
+            text += "  " + generateStatisticsText(m_statistics.at(i));
+        }
+        QListWidgetItem *item = new QListWidgetItem(text, rulesListWidget);
         
         // 设置项的颜色，根据规则是否启用
         if (!rule.enabled) {
             item->setForeground(Qt::gray);
+        } else if (hasStatistics && m_statistics.at(i).hits == 0) {
+            item->setForeground(Qt::darkRed);
+            item->setToolTip(QStringLiteral("本次读取中这条规则从未决定任何条目的结果"));
         }
         
         // 设置图标，根据规则类型
@@ -196,11 +226,34 @@ void FilterRuleListWidget::updateRulesList()
 
 QString FilterRuleListWidget::generateRuleItemText(const FileFilterUtil::FilterRule &rule) const
 {
-    QString typeStr = (rule.matchType == FileFilterUtil::MatchType::Wildcard) ? 
-                     QStringLiteral("通配符") : QStringLiteral("正则");
+    QString typeStr;
+    switch (rule.matchType) {
+    case FileFilterUtil::MatchType::Wildcard:
+        typeStr = QStringLiteral("通配符");
+        break;
+    case FileFilterUtil::MatchType::Regex:
+        typeStr = QStringLiteral("正则");
+        break;
+    case FileFilterUtil::MatchType::Gitignore:
+        typeStr = QStringLiteral("gitignore");
+        break;
+    }
     QString modeStr = (rule.filterMode == FileFilterUtil::FilterMode::Include) ? 
                      QStringLiteral("包含") : QStringLiteral("排除");
     QString enabledStr = rule.enabled ? QStringLiteral("") : QStringLiteral("(禁用)");
     
     return QString("[%1, %2] %3 %4").arg(typeStr, modeStr, rule.pattern, enabledStr);
-} 
\ No newline at end of file
+}
+
+QString FilterRuleListWidget::generateStatisticsText(const FileFilterUtil::RuleStatistics &statistics) const
+{
+    // 用时以毫秒显示，同时给出平均每次检查的纳秒数
+    const quint64 checks = statistics.hits + statistics.misses;
+    const double milliseconds = statistics.nanoseconds / 1000000.0;
+    const quint64 perCheck = checks > 0 ? statistics.nanoseconds / checks : 0;
+    return QStringLiteral("命中 %1 / 未命中 %2, %3 ms (%4 ns/次)")
+        .arg(statistics.hits)
+        .arg(statistics.misses)
+        .arg(milliseconds, 0, 'f', 2)
+        .arg(perCheck);
+}
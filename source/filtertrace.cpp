@@ -0,0 +1,91 @@
+#include "filtertrace.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+namespace {
+// 缓冲区容纳的记录数，写满后从头覆盖
+const quint64 TraceCapacity = 1 << 16;
+// 二进制格式的标识和版本号
+const char TraceMagic[8] = {'A', 'I', 'D', 'T', 'R', 'A', 'C', 'E'};
+const quint32 TraceVersion = 1;
+static_assert(sizeof(FilterTrace::Record) == 16, "跟踪记录的二进制格式固定为16字节");
+
+// 首次启用时分配，之后不再释放
+std::atomic<FilterTrace::Record *> traceBuffer{nullptr};
+std::atomic<quint64> traceNext{0};
+QElapsedTimer traceClock;
+
+quint32 hashPath(const QString &path)
+{
+    quint32 hash = 2166136261u;
+    for (const QChar c : path) {
+        hash ^= c.unicode();
+        hash *= 16777619u;
+    }
+    return hash;
+}
+}
+
+std::atomic<int> FilterTrace::enabledCategories{0};
+
+void FilterTrace::setCategories(Categories categories)
+{
+    if (categories && !traceBuffer.load(std::memory_order_acquire)) {
+        traceClock.start();
+        traceBuffer.store(new Record[TraceCapacity](), std::memory_order_release);
+    }
+    enabledCategories.store(static_cast<int>(categories), std::memory_order_relaxed);
+}
+
+void FilterTrace::record(Category category, Event event, const QString &path, int rule)
+{
+    Record *buffer = traceBuffer.load(std::memory_order_acquire);
+    if (!buffer) {
+        return;
+    }
+
+    const quint64 index = traceNext.fetch_add(1, std::memory_order_relaxed);
+    Record &record = buffer[index % TraceCapacity];
+    record.timestamp = traceClock.nsecsElapsed();
+    record.pathHash = hashPath(path);
+    record.rule = static_cast<qint16>(rule);
+    record.category = static_cast<quint8>(category);
+    record.event = static_cast<quint8>(event);
+}
+
+QVector<FilterTrace::Record> FilterTrace::snapshot()
+{
+    QVector<Record> records;
+    const Record *buffer = traceBuffer.load(std::memory_order_acquire);
+    if (!buffer) {
+        return records;
+    }
+
+    // 只保留最近的TraceCapacity条记录，从最早的一条开始输出
+    const quint64 end = traceNext.load(std::memory_order_relaxed);
+    const quint64 begin = end - std::min(end, TraceCapacity);
+    records.reserve(static_cast<int>(end - begin));
+    for (quint64 i = begin; i < end; ++i) {
+        records.append(buffer[i % TraceCapacity]);
+    }
+    return records;
+}
+
+bool FilterTrace::write(QIODevice *device)
+{
+    const QVector<Record> records = snapshot();
+    const quint32 count = static_cast<quint32>(records.size());
+    const qint64 size = static_cast<qint64>(records.size()) * static_cast<qint64>(sizeof(Record));
+
+    return device->write(TraceMagic, sizeof(TraceMagic)) == static_cast<qint64>(sizeof(TraceMagic))
+        && device->write(reinterpret_cast<const char *>(&TraceVersion), sizeof(TraceVersion)) == static_cast<qint64>(sizeof(TraceVersion))
+        && device->write(reinterpret_cast<const char *>(&count), sizeof(count)) == static_cast<qint64>(sizeof(count))
+        && device->write(reinterpret_cast<const char *>(records.constData()), size) == size;
+}
+
+void FilterTrace::clear()
+{
+    traceNext.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,218 @@
+#include "ignorerules.h"
+
+namespace {
+// 含有这些字符的模式需要转换为正则表达式
+const QString GlobCharacters = QStringLiteral("*?[\\");
+
+// 路径的最后一段（名称）
+QStringView baseName(QStringView path)
+{
+    return path.mid(path.lastIndexOf('/') + 1);
+}
+}
+
+IgnoreRules::IgnoreRules(Qt::CaseSensitivity sensitivity)
+    : caseSensitivity(sensitivity)
+{
+}
+
+bool IgnoreRules::addLine(const QString &line, int source, bool invert)
+{
+    // 去掉行尾的换行符和未转义的空格
+    QString glob = line;
+    while (glob.endsWith('\n') || glob.endsWith('\r')) {
+        glob.chop(1);
+    }
+    while (glob.endsWith(' ') && !glob.endsWith("\\ ")) {
+        glob.chop(1);
+    }
+    if (glob.isEmpty() || glob.startsWith('#')) {
+        return false;
+    }
+
+    Pattern pattern;
+    pattern.source = source;
+    pattern.negated = glob.startsWith('!');
+    if (pattern.negated) {
+        glob.remove(0, 1);
+    }
+    pattern.negated = pattern.negated != invert;
+
+    pattern.directoryOnly = glob.endsWith('/');
+    if (pattern.directoryOnly) {
+        glob.chop(1);
+    }
+
+    // 开头或中间含有/的模式相对于基准目录锚定
+    pattern.anchored = glob.contains('/');
+    if (glob.startsWith('/')) {
+        glob.remove(0, 1);
+    }
+    if (glob.isEmpty()) {
+        return false;
+    }
+
+    bool literal = true;
+    for (const QChar c : glob) {
+        if (GlobCharacters.contains(c)) {
+            literal = false;
+            break;
+        }
+    }
+    if (literal) {
+        pattern.literal = glob;
+    } else {
+        pattern.expression = QRegularExpression(globToRegularExpression(glob),
+                                                caseSensitivity == Qt::CaseInsensitive
+                                                    ? QRegularExpression::CaseInsensitiveOption
+                                                    : QRegularExpression::NoPatternOption);
+        pattern.expression.optimize();
+        if (!pattern.expression.isValid()) {
+            return false;
+        }
+    }
+
+    patterns.append(pattern);
+    ignoringPatterns += pattern.negated ? 0 : 1;
+    return true;
+}
+
+void IgnoreRules::addLines(const QStringList &lines, int source)
+{
+    for (const QString &line : lines) {
+        addLine(line, source);
+    }
+}
+
+bool IgnoreRules::isEmpty() const
+{
+    return patterns.isEmpty();
+}
+
+int IgnoreRules::size() const
+{
+    return patterns.size();
+}
+
+bool IgnoreRules::canIgnore() const
+{
+    return ignoringPatterns > 0;
+}
+
+IgnoreRules::Verdict IgnoreRules::match(QStringView relativePath, bool isDirectory, int *source) const
+{
+    if (patterns.isEmpty() || relativePath.isEmpty()) {
+        return Verdict::Unmatched;
+    }
+
+    // 以最后一个匹配的模式为准，从后往前找到第一个即可
+    const QStringView name = baseName(relativePath);
+    for (int i = patterns.size() - 1; i >= 0; --i) {
+        const Pattern &pattern = patterns.at(i);
+        if (pattern.directoryOnly && !isDirectory) {
+            continue;
+        }
+
+        const QStringView subject = pattern.anchored ? relativePath : name;
+        const bool matched = pattern.literal.isEmpty()
+            ? pattern.expression.matchView(subject).hasMatch()
+            : subject.compare(pattern.literal, caseSensitivity) == 0;
+        if (matched) {
+            if (source) {
+                *source = pattern.source;
+            }
+            return pattern.negated ? Verdict::Negated : Verdict::Matched;
+        }
+    }
+    return Verdict::Unmatched;
+}
+
+bool IgnoreRules::matchesWithParents(QStringView relativePath, bool isDirectory) const
+{
+    if (patterns.isEmpty()) {
+        return false;
+    }
+
+    for (qsizetype slash = relativePath.indexOf('/'); slash >= 0; slash = relativePath.indexOf('/', slash + 1)) {
+        if (match(relativePath.left(slash), true) == Verdict::Matched) {
+            return true;
+        }
+    }
+    return match(relativePath, isDirectory) == Verdict::Matched;
+}
+
+QString IgnoreRules::globToRegularExpression(const QString &glob)
+{
+    QString expression = QStringLiteral("^");
+    const int length = glob.length();
+    for (int i = 0; i < length; ++i) {
+        const QChar c = glob.at(i);
+        if (c == '*') {
+            int end = i;
+            while (end < length && glob.at(end) == '*') {
+                ++end;
+            }
+            // **只有单独占据一段路径时才匹配任意层目录，否则与*相同
+            const bool segmentStart = i == 0 || glob.at(i - 1) == '/';
+            if (end - i == 2 && segmentStart) {
+                if (end == length) {
+                    expression += QStringLiteral(".*");
+                    i = end - 1;
+                    continue;
+                }
+                if (glob.at(end) == '/') {
+                    expression += QStringLiteral("(?:.*/)?");
+                    i = end;
+                    continue;
+                }
+            }
+            expression += QStringLiteral("[^/]*");
+            i = end - 1;
+        } else if (c == '?') {
+            expression += QStringLiteral("[^/]");
+        } else if (c == '[') {
+            // 找到对应的]，开头的!或^表示取反，紧跟其后的]是普通字符
+            int end = i + 1;
+            if (end < length && (glob.at(end) == '!' || glob.at(end) == '^')) {
+                ++end;
+            }
+            if (end < length && glob.at(end) == ']') {
+                ++end;
+            }
+            while (end < length && glob.at(end) != ']') {
+                ++end;
+            }
+            if (end >= length) {
+                expression += QStringLiteral("\\[");
+                continue;
+            }
+
+            expression += '[';
+            int j = i + 1;
+            if (glob.at(j) == '!' || glob.at(j) == '^') {
+                expression += '^';
+                ++j;
+            }
+            for (; j < end; ++j) {
+                const QChar member = glob.at(j);
+                if (member == '\\' && j + 1 < end) {
+                    expression += '\\';
+                    expression += glob.at(++j);
+                } else if (member == '[' || member == ']' || member == '\\') {
+                    expression += '\\';
+                    expression += member;
+                } else {
+                    expression += member;
+                }
+            }
+            expression += ']';
+            i = end;
+        } else if (c == '\\' && i + 1 < length) {
+            expression += QRegularExpression::escape(glob.mid(++i, 1));
+        } else {
+            expression += QRegularExpression::escape(QString(c));
+        }
+    }
+    expression += '$';
+    return expression;
+}
@@ -0,0 +1,135 @@
+#include "ignorestack.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+namespace {
+// 父目录的路径（以'/'结尾），没有父目录时返回空字符串
+QString parentDirectory(const QString &directory)
+{
+    const qsizetype slash = directory.lastIndexOf('/', directory.size() - 2);
+    return slash < 0 ? QString() : directory.left(slash + 1);
+}
+}
+
+const QStringList &IgnoreStack::fileNames()
+{
+    // 同一目录中靠后的文件优先，与ripgrep等工具一致：工具专用的文件覆盖.ignore，.ignore覆盖.gitignore
+    static const QStringList names = {
+        QStringLiteral(".gitignore"),
+        QStringLiteral(".ignore"),
+        QStringLiteral(".aidoctoolsignore")
+    };
+    return names;
+}
+
+bool IgnoreStack::isIgnoreFile(const QString &name)
+{
+    return name.startsWith('.') && fileNames().contains(name);
+}
+
+QSharedPointer<const IgnoreStack> IgnoreStack::push(const QSharedPointer<const IgnoreStack> &parent,
+                                                    const QString &directory, const QStringList &files)
+{
+    QSharedPointer<IgnoreStack> stack = QSharedPointer<IgnoreStack>::create();
+    for (const QString &name : fileNames()) {
+        if (!files.contains(name)) {
+            continue;
+        }
+        QFile file(directory + name);
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        stack->rules.addLines(QString::fromUtf8(file.readAll()).split('\n'));
+    }
+
+    if (stack->rules.isEmpty()) {
+        return parent;
+    }
+    stack->parent = parent;
+    stack->baseLength = directory.size();
+    return stack;
+}
+
+bool IgnoreStack::isIgnored(const QString &path, bool isDirectory) const
+{
+    QStringView relativePath(path);
+    if (relativePath.endsWith('/')) {
+        relativePath.chop(1);
+    }
+
+    // 越深的目录优先，第一个给出结果的规则集为准
+    for (const IgnoreStack *stack = this; stack; stack = stack->parent.data()) {
+        switch (stack->rules.match(relativePath.mid(stack->baseLength), isDirectory)) {
+        case IgnoreRules::Verdict::Matched:
+            return true;
+        case IgnoreRules::Verdict::Negated:
+            return false;
+        case IgnoreRules::Verdict::Unmatched:
+            break;
+        }
+    }
+    return false;
+}
+
+void IgnoreStackMap::reset(const QString &rootDirectory, bool complete)
+{
+    QMutexLocker locker(&mutex);
+    root = rootDirectory;
+    this->complete = complete;
+    stacks.clear();
+    resolved.clear();
+}
+
+QSharedPointer<const IgnoreStack> IgnoreStackMap::enter(const QString &directory, const QStringList &files)
+{
+    const QSharedPointer<const IgnoreStack> parent = inherited(directory);
+    const QSharedPointer<const IgnoreStack> stack = files.isEmpty() ? parent : IgnoreStack::push(parent, directory, files);
+
+    QMutexLocker locker(&mutex);
+    if (stack != parent) {
+        stacks.insert(directory, stack);
+    } else {
+        stacks.remove(directory);
+    }
+    if (!complete) {
+        resolved.insert(directory);
+    }
+    return stack;
+}
+
+QSharedPointer<const IgnoreStack> IgnoreStackMap::inherited(const QString &directory)
+{
+    QMutexLocker locker(&mutex);
+    if (directory.size() <= root.size()) {
+        return QSharedPointer<const IgnoreStack>();
+    }
+
+    QString key = parentDirectory(directory);
+    if (!complete && !resolved.contains(key)) {
+        // 父目录不是在本次遍历中进入的，从文件系统补上它（及其祖先）的忽略文件
+        locker.unlock();
+        QStringList files;
+        for (const QString &name : IgnoreStack::fileNames()) {
+            if (QFileInfo::exists(key + name)) {
+                files.append(name);
+            }
+        }
+        return enter(key, files);
+    }
+
+    // 从父目录向上找到最近的含有忽略文件的目录
+    while (!stacks.isEmpty() && key.size() >= root.size()) {
+        const auto it = stacks.constFind(key);
+        if (it != stacks.constEnd()) {
+            return it.value();
+        }
+        const qsizetype slash = key.lastIndexOf('/', key.size() - 2);
+        if (slash < 0) {
+            break;
+        }
+        key.truncate(slash + 1);
+    }
+    return QSharedPointer<const IgnoreStack>();
+}
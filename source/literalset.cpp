@@ -0,0 +1,139 @@
+#include "literalset.h"
+
+#include <QHashFunctions>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LITERALSET_SSE2
+#endif
+
+namespace {
+// 初始槽位数，装载率超过一半时翻倍
+const int InitialSlotCount = 16;
+}
+
+void LiteralSet::foldCase(const char16_t *text, qsizetype length, char16_t *folded)
+{
+    qsizetype i = 0;
+#ifdef LITERALSET_SSE2
+    // 先把整块按ASCII规则折叠（只有A-Z加0x20），块中出现非ASCII字符时再逐个查表修正；
+    // 有符号比较下0x8000以上的字符为负数，与0x80到0x7FFF的字符一样不会落入A-Z
+    const __m128i beforeUpper = _mm_set1_epi16('A' - 1);
+    const __m128i afterUpper = _mm_set1_epi16('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi16(0x20);
+    const __m128i nonAsciiBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 8 <= length; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(chunk, beforeUpper), _mm_cmplt_epi16(chunk, afterUpper));
+        const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(chunk, nonAsciiBits), _mm_setzero_si128());
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(folded + i), _mm_add_epi16(chunk, _mm_and_si128(upper, caseBit)));
+        if (_mm_movemask_epi8(ascii) != 0xFFFF) {
+            for (qsizetype j = i; j < i + 8; ++j) {
+                folded[j] = foldCase(folded[j]);
+            }
+        }
+    }
+#endif
+    for (; i < length; ++i) {
+        folded[i] = foldCase(text[i]);
+    }
+}
+
+QString LiteralSet::foldCase(QStringView text)
+{
+    QString folded(text.size(), Qt::Uninitialized);
+    foldCase(text.utf16(), text.size(), reinterpret_cast<char16_t *>(folded.data()));
+    return folded;
+}
+
+void LiteralSet::insert(QStringView literal, int value)
+{
+    if (slots.isEmpty()) {
+        slots.resize(InitialSlotCount);
+    } else if ((count + 1) * 2 > slots.size()) {
+        grow();
+    }
+
+    const QString key = foldCase(literal);
+    const size_t hash = qHash(QStringView(key));
+    Slot &slot = slots[slotIndex(key, hash)];
+    if (slot.value >= 0) {
+        return;
+    }
+    slot.key = key;
+    slot.hash = hash;
+    slot.value = value;
+    ++count;
+
+    const auto length = std::lower_bound(lengths.begin(), lengths.end(), key.size());
+    if (length == lengths.end() || *length != key.size()) {
+        lengths.insert(length, static_cast<int>(key.size()));
+    }
+}
+
+bool LiteralSet::isEmpty() const
+{
+    return count == 0;
+}
+
+int LiteralSet::find(QStringView folded) const
+{
+    if (count == 0) {
+        return -1;
+    }
+    return slots.at(slotIndex(folded, qHash(folded))).value;
+}
+
+int LiteralSet::findPrefix(QStringView folded) const
+{
+    for (const int length : lengths) {
+        if (length > folded.size()) {
+            break;
+        }
+        const int value = find(folded.left(length));
+        if (value >= 0) {
+            return value;
+        }
+    }
+    return -1;
+}
+
+int LiteralSet::findSuffix(QStringView folded) const
+{
+    for (const int length : lengths) {
+        if (length > folded.size()) {
+            break;
+        }
+        const int value = find(folded.right(length));
+        if (value >= 0) {
+            return value;
+        }
+    }
+    return -1;
+}
+
+int LiteralSet::slotIndex(QStringView key, size_t hash) const
+{
+    // 线性探测，装载率不超过一半，总能遇到空槽位
+    const size_t mask = static_cast<size_t>(slots.size()) - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots.at(static_cast<int>(i));
+        if (slot.value < 0 || (slot.hash == hash && QStringView(slot.key) == key)) {
+            return static_cast<int>(i);
+        }
+    }
+}
+
+void LiteralSet::grow()
+{
+    QVector<Slot> previous;
+    previous.swap(slots);
+    slots.resize(previous.size() * 2);
+    for (Slot &slot : previous) {
+        if (slot.value >= 0) {
+            slots[slotIndex(slot.key, slot.hash)] = std::move(slot);
+        }
+    }
+}
@@ -1,10 +1,19 @@
 #include "mainwindow.h"
+#include "commandlinetool.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QIcon>
 
 int main(int argc, char *argv[])
 {
+    // 以子命令启动时不创建任何窗口部件，执行完毕后直接退出
+    if (CommandLineTool::isCommandLine(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        CommandLineTool tool;
+        return tool.run(app.arguments());
+    }
+    
     QApplication app(argc, argv);
     
     // 设置应用程序图标
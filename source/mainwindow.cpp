@@ -10,21 +10,24 @@
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QGroupBox>
+#include <QHeaderView>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QDebug>
 #include <QSplitter>
 #include <QTabWidget>
-#include <QTextStream>
 #include <QStandardPaths>
 #include <QApplication>
 #include <QDesktopServices>
 #include <QUrl>
+#include <QSettings>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , directoryReader(new DirectoryTreeReader(this))
+    , scanExportFile(nullptr)
+    , scanExporter(nullptr)
 {
     setupUI();
     setupMenus();
@@ -37,11 +40,13 @@ MainWindow::MainWindow(QWidget *parent)
     connect(startButton, &QPushButton::clicked, this, &MainWindow::startReading);
     connect(cancelButton, &QPushButton::clicked, this, &MainWindow::cancelReading);
     connect(filterCheckBox, &QCheckBox::toggled, this, &MainWindow::toggleFilterOptions);
-    connect(directoryTreeWidget, &QTreeWidget::itemSelectionChanged, this, &MainWindow::updateTextDisplay);
+    connect(directoryTreeView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::updateTextDisplay);
     
     // 连接目录读取器的信号
     connect(directoryReader, &DirectoryTreeReader::progressUpdated, this, &MainWindow::updateProgress);
     connect(directoryReader, &DirectoryTreeReader::readingFinished, this, &MainWindow::readingFinished);
+    connect(directoryReader, &DirectoryTreeReader::treeUpdated, this, &MainWindow::directoryTreeUpdated);
+    connect(watchCheckBox, &QCheckBox::toggled, directoryReader, &DirectoryTreeReader::setWatchEnabled);
 
     // 连接样式管理器信号
     connect(StyleSheetManager::instance(), &StyleSheetManager::themeChanged, this, &MainWindow::onThemeChanged);
@@ -53,16 +58,18 @@ MainWindow::MainWindow(QWidget *parent)
     cancelButton->setEnabled(false);
     toggleFilterOptions(false);
     filterCheckBox->setChecked(false);
-    
-    // 设置目录树读取器
-    directoryReader->setTreeWidget(directoryTreeWidget);
 
     // 加载保存的样式设置
     StyleSheetManager::instance()->loadSettings();
+    
+    restoreLastDirectory();
 }
 
 MainWindow::~MainWindow()
 {
+    // 读取线程可能仍在使用导出器，先销毁读取器（等待读取结束）再释放导出器
+    delete directoryReader;
+    delete scanExporter;
 }
 
 void MainWindow::setupUI()
@@ -114,14 +121,31 @@ void MainWindow::setupUI()
     filterRuleListWidget = new FilterRuleListWidget(optionsGroupBox);
     filterRuleListWidget->setEnabled(false);
     
+    profileCheckBox = new QCheckBox("统计规则命中和用时", optionsGroupBox);
+    profileCheckBox->setToolTip("读取完成后在每条规则后面显示命中次数、未命中次数和累计用时，读取会变慢");
+    profileCheckBox->setEnabled(false);
+    
     readFilesCheckBox = new QCheckBox("读取文件名", optionsGroupBox);
     readFilesCheckBox->setChecked(true);
     
+    watchCheckBox = new QCheckBox("监视目录变化", optionsGroupBox);
+    watchCheckBox->setToolTip("读取完成后自动更新新增、删除或移动的文件和目录");
+    
+    lazyCheckBox = new QCheckBox("展开时读取更深的目录", optionsGroupBox);
+    lazyCheckBox->setToolTip("只预先读取到搜索深度，更深的目录在展开时才读取");
+    
+    rollupCheckBox = new QCheckBox("统计目录大小", optionsGroupBox);
+    rollupCheckBox->setToolTip("读取时统计每个目录的文件数、总大小和最新修改时间，可按这些列排序");
+    
     optionsLayout->addWidget(depthLabel, 0, 0);
     optionsLayout->addWidget(depthSpinBox, 0, 1);
     optionsLayout->addWidget(filterCheckBox, 1, 0, 1, 2);
     optionsLayout->addWidget(filterRuleListWidget, 2, 0, 1, 2);
-    optionsLayout->addWidget(readFilesCheckBox, 3, 0, 1, 2);
+    optionsLayout->addWidget(profileCheckBox, 3, 0, 1, 2);
+    optionsLayout->addWidget(readFilesCheckBox, 4, 0, 1, 2);
+    optionsLayout->addWidget(watchCheckBox, 5, 0, 1, 2);
+    optionsLayout->addWidget(lazyCheckBox, 6, 0, 1, 2);
+    optionsLayout->addWidget(rollupCheckBox, 7, 0, 1, 2);
     
     // 操作按钮区域
     QHBoxLayout *actionLayout = new QHBoxLayout();
@@ -136,13 +160,21 @@ void MainWindow::setupUI()
     statusLabel = new QLabel(leftWidget);
     statusLabel->setText("就绪");
     
-    // 目录树显示区域
-    directoryTreeWidget = new QTreeWidget(leftWidget);
-    directoryTreeWidget->setHeaderLabels(QStringList() << "名称" << "类型" << "路径");
-    directoryTreeWidget->setColumnWidth(0, 200);
-    directoryTreeWidget->setColumnWidth(1, 80);
-    directoryTreeWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
-    directoryTreeWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    // 目录树显示区域，数据由目录树读取器持有的模型按需提供
+    directoryTreeView = new QTreeView(leftWidget);
+    directoryTreeView->setModel(directoryReader->model());
+    directoryTreeView->setUniformRowHeights(true);
+    directoryTreeView->setColumnWidth(0, 200);
+    directoryTreeView->setColumnWidth(1, 80);
+    directoryTreeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    directoryTreeView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    
+    // 默认按名称升序，即节点本身的顺序；统计列只在启用统计时显示
+    directoryTreeView->header()->setSortIndicator(DirectoryTreeModel::NameColumn, Qt::AscendingOrder);
+    directoryTreeView->setSortingEnabled(true);
+    for (int column = DirectoryTreeModel::FileCountColumn; column < DirectoryTreeModel::ColumnCount; ++column) {
+        directoryTreeView->setColumnHidden(column, true);
+    }
     
     // 将所有组件添加到左侧布局
     leftLayout->addWidget(directoryGroupBox);
@@ -150,7 +182,7 @@ void MainWindow::setupUI()
     leftLayout->addLayout(actionLayout);
     leftLayout->addWidget(progressBar);
     leftLayout->addWidget(statusLabel);
-    leftLayout->addWidget(directoryTreeWidget);
+    leftLayout->addWidget(directoryTreeView);
     
     // 右侧控件 - 文本显示
     directoryTextDisplay = new QTextEdit(mainSplitter);
@@ -184,6 +216,7 @@ void MainWindow::setupMenus()
     // 文件菜单
     fileMenu = menuBar->addMenu("文件");
     exportAction = fileMenu->addAction("导出为TXT文件", this, &MainWindow::exportToTxtFile);
+    exportScanAction = fileMenu->addAction("读取并导出为NDJSON/JSON/CSV", this, &MainWindow::exportScan);
     importFilterAction = fileMenu->addAction("导入过滤规则", this, &MainWindow::importFilterRules);
     fileMenu->addSeparator();
     fileMenu->addAction("退出", this, &QMainWindow::close);
@@ -229,6 +262,28 @@ void MainWindow::switchToPage(int index)
     stackedWidget->setCurrentIndex(index);
 }
 
+void MainWindow::restoreLastDirectory()
+{
+    QSettings settings("AIDocTools", "AIDocTools");
+    const QString lastDirectory = settings.value("directoryReader/lastDirectory").toString();
+    if (lastDirectory.isEmpty() || !QDir(lastDirectory).exists()) {
+        return;
+    }
+    
+    directoryLineEdit->setText(lastDirectory);
+    
+    // 快照只有在读取选项与上次一致时才会被使用，这里使用的是界面上的默认选项
+    directoryReader->setMaxDepth(depthSpinBox->value());
+    directoryReader->setReadFiles(readFilesCheckBox->isChecked());
+    directoryReader->setLazyLoading(lazyCheckBox->isChecked());
+    directoryReader->setComputeRollups(rollupCheckBox->isChecked());
+    if (directoryReader->loadSnapshot(lastDirectory)) {
+        statusLabel->setText("已从快照恢复目录树，正在后台校验");
+        directoryTreeView->expand(directoryReader->model()->index(0, 0));
+        updateTextDisplay();
+    }
+}
+
 void MainWindow::browseDirectory()
 {
     QString dir = QFileDialog::getExistingDirectory(this, "选择目录",
@@ -247,13 +302,21 @@ void MainWindow::startReading()
         return;
     }
 
-    // 清空树控件
-    directoryTreeWidget->clear();
+    // 记住本次读取的目录，下次启动时从快照恢复
+    QSettings settings("AIDocTools", "AIDocTools");
+    settings.setValue("directoryReader/lastDirectory", rootPath);
+    
+    // 清空文本显示，模型由读取器在开始读取时重置
     directoryTextDisplay->clear();
     
     // 设置选项
     directoryReader->setMaxDepth(depthSpinBox->value());
     directoryReader->setReadFiles(readFilesCheckBox->isChecked());
+    directoryReader->setLazyLoading(lazyCheckBox->isChecked());
+    directoryReader->setComputeRollups(rollupCheckBox->isChecked());
+    for (int column = DirectoryTreeModel::FileCountColumn; column < DirectoryTreeModel::ColumnCount; ++column) {
+        directoryTreeView->setColumnHidden(column, !rollupCheckBox->isChecked());
+    }
     
     // 设置过滤规则
     if (filterCheckBox->isChecked()) {
@@ -261,6 +324,7 @@ void MainWindow::startReading()
     } else {
         directoryReader->setFilterRules(QList<FileFilterUtil::FilterRule>());
     }
+    FileFilterUtil::setProfilingEnabled(filterCheckBox->isChecked() && profileCheckBox->isChecked());
     
     // 更新UI状态
     startButton->setEnabled(false);
@@ -279,9 +343,10 @@ void MainWindow::cancelReading()
     statusLabel->setText("正在取消...");
 }
 
-void MainWindow::updateProgress(int value)
+void MainWindow::updateProgress(int value, const QString &detail)
 {
     progressBar->setValue(value);
+    statusLabel->setText("正在读取目录... " + detail);
 }
 
 void MainWindow::readingFinished()
@@ -290,18 +355,52 @@ void MainWindow::readingFinished()
     cancelButton->setEnabled(false);
     progressBar->setVisible(false);
     
-    if (directoryTreeWidget->topLevelItemCount() > 0) {
+    if (directoryReader->model()->rowCount() > 0) {
         statusLabel->setText("读取完成");
-        directoryTreeWidget->expandItem(directoryTreeWidget->topLevelItem(0));
+        directoryTreeView->expand(directoryReader->model()->index(0, 0));
         updateTextDisplay();
     } else {
         statusLabel->setText("操作已取消");
     }
+    
+    // 显示本次读取中各条规则的命中统计
+    if (FileFilterUtil::isProfilingEnabled()) {
+        FileFilterUtil::setProfilingEnabled(false);
+        filterRuleListWidget->setRuleStatistics(directoryReader->ruleStatistics());
+    }
+    
+    if (scanExporter) {
+        const bool failed = scanExporter->hasError();
+        const qint64 records = scanExporter->recordCount();
+        delete scanExporter;
+        scanExporter = nullptr;
+        scanExportFile->close();
+        delete scanExportFile;
+        scanExportFile = nullptr;
+        
+        if (failed) {
+            QMessageBox::critical(this, "错误", "写入导出文件失败");
+        } else {
+            statusLabel->setText(QString("%1，已导出%2条记录").arg(statusLabel->text()).arg(records));
+        }
+    }
+}
+
+void MainWindow::directoryTreeUpdated()
+{
+    // 读取进行中不处理，读取完成时会统一刷新
+    if (!startButton->isEnabled()) {
+        return;
+    }
+    
+    statusLabel->setText("目录已更新");
+    updateTextDisplay();
 }
 
 void MainWindow::toggleFilterOptions(bool enabled)
 {
     filterRuleListWidget->setEnabled(enabled);
+    profileCheckBox->setEnabled(enabled);
     
     // 更新DirectoryTreeReader的过滤规则状态
     if (directoryReader) {
@@ -312,7 +411,7 @@ void MainWindow::toggleFilterOptions(bool enabled)
         }
         
         // 提示用户重新读取，但不自动触发
-        if (directoryTreeWidget->topLevelItemCount() > 0) {
+        if (directoryReader->model()->rowCount() > 0) {
             statusLabel->setText("过滤选项已" + QString(enabled ? "启用" : "禁用") + "，请点击\"开始读取\"按钮重新应用");
         }
     }
@@ -322,93 +421,18 @@ void MainWindow::updateTextDisplay()
 {
     directoryTextDisplay->clear();
     
-    QTreeWidgetItem *rootItem = nullptr;
-    if (directoryTreeWidget->selectedItems().isEmpty()) {
-        if (directoryTreeWidget->topLevelItemCount() > 0) {
-            rootItem = directoryTreeWidget->topLevelItem(0);
-        }
-    } else {
-        rootItem = directoryTreeWidget->selectedItems().first();
-    }
-    
-    if (rootItem) {
-        QString text;
-        // 使用选中的项生成文本表示
-        if (rootItem == directoryTreeWidget->topLevelItem(0)) {
-            // 如果是根项，使用 DirectoryTreeReader 的方法
-            text = directoryReader->generateTextRepresentation();
-        } else {
-            // 否则手动生成文本表示
-            text = generateTextRepresentation(rootItem);
-        }
-        directoryTextDisplay->setPlainText(text);
-    }
-}
-
-QString MainWindow::generateTextRepresentation(QTreeWidgetItem *item, int level)
-{
-    if (!item) {
-        return QString();
-    }
-    
-    QString result;
-    
-    // 根节点特殊处理
-    if (level == 0) {
-        result = item->text(0) + "/\n";
-    } else {
-        // 构建前缀
-        QString prefix;
-        for (int i = 0; i < level - 1; i++) {
-            prefix += "│   ";
-        }
-        
-        // 添加当前项的连接线
-        if (level > 0) {
-            prefix += "├── ";
-        }
-        
-        // 添加当前项
-        if (item->text(1) == "目录") {
-            result = prefix + item->text(0) + "/\n";
-        } else {
-            result = prefix + item->text(0) + "\n";
-        }
+    if (directoryReader->model()->rowCount() == 0) {
+        return;
     }
     
-    // 处理子项
-    int childCount = item->childCount();
-    for (int i = 0; i < childCount; ++i) {
-        QTreeWidgetItem *child = item->child(i);
-        
-        // 最后一个子项使用不同的连接线
-        if (i == childCount - 1) {
-            // 保存原始结果
-            QString originalResult = result;
-            
-            // 将下一级的"├──"替换为"└──"
-            QString childText = generateTextRepresentation(child, level + 1);
-            if (level >= 0) {
-                childText.replace(level * 4, 4, "└── ");
-                
-                // 将后续行的"│   "替换为"    "
-                int pos = childText.indexOf('\n');
-                while (pos >= 0 && pos < childText.length() - 1) {
-                    int prefixPos = pos + 1 + level * 4;
-                    if (prefixPos + 4 <= childText.length() && 
-                        childText.mid(prefixPos, 4) == "│   ") {
-                        childText.replace(prefixPos, 4, "    ");
-                    }
-                    pos = childText.indexOf('\n', pos + 1);
-                }
-            }
-            result = originalResult + childText;
-        } else {
-            result += generateTextRepresentation(child, level + 1);
-        }
+    // 未选中任何项时显示整个目录树，否则显示第一个选中项的子结构
+    QModelIndex rootIndex;
+    const QModelIndexList selected = directoryTreeView->selectionModel()->selectedRows(0);
+    if (!selected.isEmpty()) {
+        rootIndex = selected.first();
     }
     
-    return result;
+    directoryTextDisplay->setPlainText(directoryReader->generateTextRepresentation(rootIndex));
 }
 
 void MainWindow::exportToTxtFile()
@@ -432,13 +456,56 @@ void MainWindow::exportToTxtFile()
         return;
     }
     
-    QTextStream out(&file);
-    out << directoryTextDisplay->toPlainText();
+    // 与文本显示保持一致：有选中项时导出其子结构
+    QModelIndex rootIndex;
+    const QModelIndexList selected = directoryTreeView->selectionModel()->selectedRows(0);
+    if (!selected.isEmpty()) {
+        rootIndex = selected.first();
+    }
+    
+    const bool written = directoryReader->writeTextRepresentation(&file, rootIndex);
     file.close();
+    if (!written) {
+        QMessageBox::critical(this, "错误", "写入文件失败");
+        return;
+    }
     
     QMessageBox::information(this, "成功", "文件已成功导出");
 }
 
+void MainWindow::exportScan()
+{
+    if (directoryLineEdit->text().isEmpty()) {
+        QMessageBox::warning(this, "警告", "请选择一个目录");
+        return;
+    }
+    if (!startButton->isEnabled()) {
+        QMessageBox::information(this, "提示", "请等待当前读取完成");
+        return;
+    }
+    
+    QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString fileName = QFileDialog::getSaveFileName(this, "读取并导出",
+                                                  defaultPath + "/目录结构.ndjson",
+                                                  "NDJSON (*.ndjson);;JSON (*.json);;CSV (*.csv)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    scanExportFile = new QFile(fileName, this);
+    if (!scanExportFile->open(QIODevice::WriteOnly)) {
+        QMessageBox::critical(this, "错误", "无法打开文件进行写入");
+        delete scanExportFile;
+        scanExportFile = nullptr;
+        return;
+    }
+    
+    // 条目在读取过程中逐批写入文件，读取完成时文件也随之写完
+    scanExporter = new ScanExporter(scanExportFile, ScanExporter::formatForFile(fileName));
+    directoryReader->setExporter(scanExporter);
+    startReading();
+}
+
 void MainWindow::importFilterRules()
 {
     // 使用新的过滤规则对话框替代原有的导入逻辑
@@ -485,7 +552,7 @@ void MainWindow::handleFilterRulesChanged(const QList<FileFilterUtil::FilterRule
     
     // 如果启用了过滤并且已经读取了目录，则重新应用过滤规则
     // 但不立即触发重新读取，而是让用户手动点击"开始读取"按钮
-    if (filterCheckBox->isChecked() && directoryTreeWidget->topLevelItemCount() > 0) {
+    if (filterCheckBox->isChecked() && directoryReader->model()->rowCount() > 0) {
         statusLabel->setText("过滤规则已更新，请点击\"开始读取\"按钮重新应用");
     }
 }
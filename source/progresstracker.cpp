@@ -0,0 +1,100 @@
+#include "progresstracker.h"
+
+#include <QTimer>
+#include <QLocale>
+
+namespace {
+// 发布间隔（毫秒），约30Hz
+const int PublishInterval = 33;
+// 吞吐量指数平滑系数，越小越平稳
+const double RateSmoothing = 0.2;
+}
+
+ProgressTracker::ProgressTracker(Unit unit, QObject *parent)
+    : QObject(parent)
+    , unit(unit)
+    , total(0)
+    , completed(0)
+    , timer(new QTimer(this))
+    , lastCompleted(0)
+    , lastElapsed(0)
+    , rate(0.0)
+    , lastValue(0)
+{
+    timer->setInterval(PublishInterval);
+    connect(timer, &QTimer::timeout, this, &ProgressTracker::publish);
+}
+
+void ProgressTracker::start()
+{
+    total = 0;
+    completed = 0;
+    lastCompleted = 0;
+    lastElapsed = 0;
+    rate = 0.0;
+    lastValue = 0;
+    elapsed.start();
+    timer->start();
+}
+
+void ProgressTracker::finish()
+{
+    if (!timer->isActive()) {
+        return;
+    }
+    timer->stop();
+    publish();
+}
+
+void ProgressTracker::addTotal(qint64 amount)
+{
+    total.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void ProgressTracker::addCompleted(qint64 amount)
+{
+    completed.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void ProgressTracker::publish()
+{
+    const qint64 totalNow = total.load(std::memory_order_relaxed);
+    const qint64 completedNow = qMin(completed.load(std::memory_order_relaxed), totalNow);
+    if (totalNow <= 0) {
+        return;
+    }
+
+    // 总量增长时百分比可能变小，发布值保持单调
+    const int value = qMax(lastValue, static_cast<int>(completedNow * 100 / totalNow));
+    lastValue = value;
+
+    // 按相邻两次发布之间的增量计算瞬时吞吐量，再做指数平滑
+    const qint64 now = elapsed.elapsed();
+    const qint64 interval = now - lastElapsed;
+    if (interval > 0) {
+        const double instant = (completedNow - lastCompleted) * 1000.0 / interval;
+        rate = (lastElapsed == 0) ? instant : rate + RateSmoothing * (instant - rate);
+        lastCompleted = completedNow;
+        lastElapsed = now;
+    }
+
+    QString detail = formatAmount(completedNow) + " / " + formatAmount(totalNow);
+    if (rate > 0.0) {
+        detail += "，" + formatAmount(static_cast<qint64>(rate)) + "/秒";
+        const qint64 remaining = static_cast<qint64>((totalNow - completedNow) / rate);
+        if (completedNow < totalNow) {
+            detail += "，剩余约" + (remaining >= 60 ? QString("%1分%2秒").arg(remaining / 60).arg(remaining % 60)
+                                                    : QString("%1秒").arg(remaining));
+        }
+    }
+
+    emit progressUpdated(value, detail);
+}
+
+QString ProgressTracker::formatAmount(qint64 amount) const
+{
+    if (unit == Unit::Bytes) {
+        return QLocale().formattedDataSize(amount);
+    }
+    return QString("%1个目录").arg(amount);
+}
@@ -0,0 +1,289 @@
+#include "scanexporter.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QTimeZone>
+
+namespace {
+// 缓冲区积累到该大小时写入设备
+const int ExportChunkSize = 64 * 1024;
+// CSV表头
+const char *const CsvHeader = "path,type,size,mtime,depth\n";
+
+// 修改时间统一输出为UTC的ISO 8601格式
+QByteArray formatTime(qint64 msecs)
+{
+    return QDateTime::fromMSecsSinceEpoch(msecs, QTimeZone::UTC).toString(Qt::ISODateWithMs).toUtf8();
+}
+}
+
+ScanExporter::ScanExporter(QIODevice *device, Format format)
+    : device(device)
+    , exportFormat(format)
+    , error(false)
+    , finished(false)
+    , records(0)
+    , openDirectories(0)
+{
+    buffer.reserve(ExportChunkSize + 4096);
+}
+
+ScanExporter::Format ScanExporter::formatForFile(const QString &fileName, Format fallback)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "ndjson" || suffix == "jsonl") {
+        return Format::Ndjson;
+    }
+    if (suffix == "json") {
+        return Format::Json;
+    }
+    if (suffix == "csv") {
+        return Format::Csv;
+    }
+    return fallback;
+}
+
+ScanExporter::Format ScanExporter::format() const
+{
+    return exportFormat;
+}
+
+bool ScanExporter::requiresDepthFirst() const
+{
+    return exportFormat == Format::Json;
+}
+
+void ScanExporter::begin(const QString &rootPath)
+{
+    buffer.clear();
+    error = false;
+    finished = false;
+    records = 0;
+    pendingDirectories.clear();
+    frames.clear();
+    openDirectories = 0;
+
+    if (exportFormat == Format::Csv) {
+        buffer.append(CsvHeader);
+    }
+
+    // 根目录本身也是一条记录，深度为0
+    const DirectoryWalker::Entry root(QString(), true);
+    if (exportFormat == Format::Json) {
+        buffer.append('{');
+        writeJsonFields(rootPath, root, 0);
+        buffer.append(",\"children\":[");
+        ++openDirectories;
+        ++records;
+    } else {
+        writeRecord(rootPath, root, 0);
+    }
+    pendingDirectories.insert(0, PendingDirectory{rootPath, 0});
+}
+
+void ScanExporter::addListing(int nodeId, int firstChild, const QVector<DirectoryWalker::Entry> &entries)
+{
+    if (finished) {
+        return;
+    }
+
+    // 目录的记录在其父目录的条目中已经写出，这里只需要它的路径和深度
+    const auto it = pendingDirectories.constFind(nodeId);
+    if (it == pendingDirectories.constEnd()) {
+        return;
+    }
+    const PendingDirectory directory = it.value();
+    pendingDirectories.erase(it);
+
+    if (exportFormat == Format::Json) {
+        frames.append(Frame{entries, directory.path, directory.depth + 1, firstChild, 0});
+        advance();
+        flushIfNeeded();
+        return;
+    }
+
+    for (int i = 0; i < entries.size(); ++i) {
+        const DirectoryWalker::Entry &entry = entries.at(i);
+        const QString path = DirectoryWalker::childPath(directory.path, entry.name);
+        writeRecord(path, entry, directory.depth + 1);
+        if (entry.slot >= 0) {
+            pendingDirectories.insert(firstChild + i, PendingDirectory{path, directory.depth + 1});
+        }
+    }
+    flushIfNeeded();
+}
+
+void ScanExporter::advance()
+{
+    // 深度优先读取保证下一次addListing()正是这里停下等待的子目录
+    while (!frames.isEmpty()) {
+        Frame &frame = frames.last();
+        if (frame.next >= frame.entries.size()) {
+            frames.removeLast();
+            buffer.append("]}");
+            --openDirectories;
+            continue;
+        }
+
+        const int index = frame.next++;
+        const DirectoryWalker::Entry &entry = frame.entries.at(index);
+        const QString path = DirectoryWalker::childPath(frame.path, entry.name);
+        if (index > 0) {
+            buffer.append(',');
+        }
+        buffer.append('{');
+        writeJsonFields(path, entry, frame.depth);
+        ++records;
+
+        if (entry.slot >= 0) {
+            buffer.append(",\"children\":[");
+            ++openDirectories;
+            pendingDirectories.insert(frame.firstChild + index, PendingDirectory{path, frame.depth});
+            return;
+        }
+        buffer.append('}');
+    }
+}
+
+void ScanExporter::finish()
+{
+    if (finished) {
+        return;
+    }
+    finished = true;
+
+    // 读取被取消时还有目录没有闭合，补全结构使输出仍是合法的JSON
+    if (exportFormat == Format::Json) {
+        for (; openDirectories > 0; --openDirectories) {
+            buffer.append("]}");
+        }
+        buffer.append('\n');
+    }
+    frames.clear();
+    pendingDirectories.clear();
+    flush();
+}
+
+void ScanExporter::flush()
+{
+    if (buffer.isEmpty() || error) {
+        return;
+    }
+    if (device->write(buffer) != buffer.size()) {
+        error = true;
+    }
+    buffer.clear();
+}
+
+bool ScanExporter::hasError() const
+{
+    return error;
+}
+
+qint64 ScanExporter::recordCount() const
+{
+    return records;
+}
+
+void ScanExporter::writeRecord(const QString &path, const DirectoryWalker::Entry &entry, int depth)
+{
+    ++records;
+    if (exportFormat == Format::Ndjson) {
+        buffer.append('{');
+        writeJsonFields(path, entry, depth);
+        buffer.append("}\n");
+        return;
+    }
+
+    // CSV：目录没有大小和修改时间，对应字段留空
+    appendCsvField(path);
+    buffer.append(entry.isDir ? ",directory," : ",file,");
+    if (!entry.isDir) {
+        buffer.append(QByteArray::number(entry.size));
+    }
+    buffer.append(',');
+    if (!entry.isDir && entry.modified > 0) {
+        buffer.append(formatTime(entry.modified));
+    }
+    buffer.append(',');
+    buffer.append(QByteArray::number(depth));
+    buffer.append('\n');
+}
+
+void ScanExporter::writeJsonFields(const QString &path, const DirectoryWalker::Entry &entry, int depth)
+{
+    buffer.append("\"path\":");
+    appendJsonString(path);
+    if (entry.isDir) {
+        buffer.append(",\"type\":\"directory\",\"size\":null,\"mtime\":null");
+    } else {
+        buffer.append(",\"type\":\"file\",\"size\":");
+        buffer.append(QByteArray::number(entry.size));
+        buffer.append(",\"mtime\":");
+        if (entry.modified > 0) {
+            buffer.append('"');
+            buffer.append(formatTime(entry.modified));
+            buffer.append('"');
+        } else {
+            buffer.append("null");
+        }
+    }
+    buffer.append(",\"depth\":");
+    buffer.append(QByteArray::number(depth));
+}
+
+void ScanExporter::flushIfNeeded()
+{
+    if (buffer.size() >= ExportChunkSize) {
+        flush();
+    }
+}
+
+void ScanExporter::appendJsonString(const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    buffer.append('"');
+    for (const char c : utf8) {
+        switch (c) {
+        case '"':
+            buffer.append("\\\"");
+            break;
+        case '\\':
+            buffer.append("\\\\");
+            break;
+        case '\n':
+            buffer.append("\\n");
+            break;
+        case '\r':
+            buffer.append("\\r");
+            break;
+        case '\t':
+            buffer.append("\\t");
+            break;
+        default:
+            // 其余控制字符用\u转义，多字节UTF-8字符原样输出
+            if (static_cast<unsigned char>(c) < 0x20) {
+                buffer.append(QByteArray("\\u00") + QByteArray::number(static_cast<unsigned char>(c), 16).rightJustified(2, '0'));
+            } else {
+                buffer.append(c);
+            }
+            break;
+        }
+    }
+    buffer.append('"');
+}
+
+void ScanExporter::appendCsvField(const QString &text)
+{
+    // 含逗号、引号或换行的字段用引号括起，内部的引号加倍
+    const QByteArray utf8 = text.toUtf8();
+    if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n') || utf8.contains('\r')) {
+        QByteArray quoted = utf8;
+        quoted.replace("\"", "\"\"");
+        buffer.append('"');
+        buffer.append(quoted);
+        buffer.append('"');
+        return;
+    }
+    buffer.append(utf8);
+}
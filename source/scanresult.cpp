@@ -0,0 +1,128 @@
+#include "scanresult.h"
+
+#include <QVarLengthArray>
+
+void ScanResult::reset(const QString &rootPath, const QString &rootName)
+{
+    clear();
+    this->rootPath = rootPath;
+
+    const QByteArray utf8Name = rootName.toUtf8();
+    Node root;
+    root.parent = -1;
+    root.firstChild = -1;
+    root.childCount = 0;
+    root.nameOffset = 0;
+    root.nameLength = static_cast<quint16>(utf8Name.size());
+    root.flags = DirectoryFlag;
+    root.reserved = 0;
+    names.append(utf8Name);
+    nodes.append(root);
+}
+
+void ScanResult::clear()
+{
+    nodes.clear();
+    names.clear();
+    rootPath.clear();
+    rollups.clear();
+}
+
+int ScanResult::appendChild(int parent, const QString &name, bool isDir)
+{
+    const QByteArray utf8Name = name.toUtf8();
+    const int node = nodes.size();
+
+    Node child;
+    child.parent = parent;
+    child.firstChild = -1;
+    child.childCount = 0;
+    child.nameOffset = static_cast<quint32>(names.size());
+    child.nameLength = static_cast<quint16>(utf8Name.size());
+    child.flags = isDir ? DirectoryFlag : 0;
+    child.reserved = 0;
+    names.append(utf8Name);
+    nodes.append(child);
+
+    Node &dir = nodes[parent];
+    if (dir.childCount == 0) {
+        dir.firstChild = node;
+    }
+    ++dir.childCount;
+    return node;
+}
+
+int ScanResult::nodeCount() const
+{
+    return nodes.size();
+}
+
+QString ScanResult::name(int node) const
+{
+    if (node < 0 || node >= nodes.size()) {
+        return QString();
+    }
+
+    const Node &n = nodes.at(node);
+    return QString::fromUtf8(names.constData() + n.nameOffset, n.nameLength);
+}
+
+QByteArray ScanResult::nameUtf8(int node) const
+{
+    if (node < 0 || node >= nodes.size()) {
+        return QByteArray();
+    }
+
+    const Node &n = nodes.at(node);
+    return QByteArray::fromRawData(names.constData() + n.nameOffset, n.nameLength);
+}
+
+bool ScanResult::isDirectory(int node) const
+{
+    if (node < 0 || node >= nodes.size()) {
+        return false;
+    }
+    return (nodes.at(node).flags & DirectoryFlag) != 0;
+}
+
+ScanResult::Rollup ScanResult::rollup(int node) const
+{
+    if (node < 0 || node >= rollups.size()) {
+        return Rollup::unknown();
+    }
+    return rollups.at(node);
+}
+
+QString ScanResult::filePath(int node) const
+{
+    if (node < 0 || node >= nodes.size()) {
+        return QString();
+    }
+    if (node == 0) {
+        return rootPath;
+    }
+
+    // 先从节点向上收集祖先并计算长度，再按从根到叶的顺序一次拼接UTF-8字节
+    QVarLengthArray<int, 32> chain;
+    int length = 0;
+    for (int current = node; current > 0; current = nodes.at(current).parent) {
+        chain.append(current);
+        length += nodes.at(current).nameLength + 1;
+    }
+
+    QByteArray relative;
+    relative.reserve(length);
+    for (int i = chain.size() - 1; i >= 0; --i) {
+        const Node &n = nodes.at(chain.at(i));
+        relative.append(names.constData() + n.nameOffset, n.nameLength);
+        if (i > 0) {
+            relative.append('/');
+        }
+    }
+
+    QString path = rootPath;
+    if (!path.endsWith('/')) {
+        path += '/';
+    }
+    return path + QString::fromUtf8(relative);
+}
@@ -0,0 +1,216 @@
+#include "scansnapshot.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <climits>
+#include <cstring>
+
+namespace {
+const char SnapshotMagic[8] = {'A', 'I', 'D', 'T', 'S', 'N', 'A', 'P'};
+// 文件格式变化时递增
+const quint32 SnapshotVersion = 1;
+const quint32 ByteOrderMark = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];                  ///< 魔数
+    quint32 version;                ///< 格式版本
+    quint32 byteOrder;              ///< 字节序标记
+    quint32 nodeSize;               ///< 单个节点的字节数
+    quint32 nodeCount;              ///< 节点数量
+    quint32 nameBytes;              ///< 名称字符串区大小
+    quint32 directoryTimeCount;     ///< 目录修改时间表条目数
+    quint32 rootPathBytes;          ///< 根目录路径的UTF-8字节数
+    quint32 reserved;               ///< 保留
+};
+
+static_assert(sizeof(DirectoryTreeModel::Node) == 20, "snapshot layout depends on the node size");
+static_assert(sizeof(ScanSnapshot::DirectoryTime) == 16, "snapshot layout depends on the directory time size");
+
+quint64 alignTo8(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+bool writePadded(QSaveFile &file, const char *data, qint64 size)
+{
+    if (size > 0 && file.write(data, size) != size) {
+        return false;
+    }
+    const qint64 padding = static_cast<qint64>(alignTo8(static_cast<quint64>(size))) - size;
+    const char zeros[8] = {};
+    return padding == 0 || file.write(zeros, padding) == padding;
+}
+}
+
+ScanSnapshot::ScanSnapshot()
+    : mapped(nullptr)
+    , nodeData(nullptr)
+    , nodeTotal(0)
+    , nameData(nullptr)
+    , nameSize(0)
+    , timeData(nullptr)
+    , timeTotal(0)
+{
+}
+
+ScanSnapshot::~ScanSnapshot()
+{
+    if (mapped) {
+        file.unmap(mapped);
+    }
+}
+
+QString ScanSnapshot::snapshotFilePath(const QByteArray &key)
+{
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/snapshots";
+    return directory + '/' + QString::fromLatin1(key) + ".snap";
+}
+
+bool ScanSnapshot::write(const QString &filePath, const QString &rootPath,
+                         const QVector<DirectoryTreeModel::Node> &nodes, const QByteArray &names,
+                         const QVector<DirectoryTime> &directoryTimes)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    const QByteArray utf8Root = rootPath.toUtf8();
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+    header.version = SnapshotVersion;
+    header.byteOrder = ByteOrderMark;
+    header.nodeSize = sizeof(DirectoryTreeModel::Node);
+    header.nodeCount = static_cast<quint32>(nodes.size());
+    header.nameBytes = static_cast<quint32>(names.size());
+    header.directoryTimeCount = static_cast<quint32>(directoryTimes.size());
+    header.rootPathBytes = static_cast<quint32>(utf8Root.size());
+
+    // 每一段按8字节对齐，映射后可以直接按结构体访问
+    const bool written =
+        writePadded(file, reinterpret_cast<const char *>(&header), sizeof(header))
+        && writePadded(file, utf8Root.constData(), utf8Root.size())
+        && writePadded(file, reinterpret_cast<const char *>(nodes.constData()),
+                       static_cast<qint64>(nodes.size()) * sizeof(DirectoryTreeModel::Node))
+        && writePadded(file, names.constData(), names.size())
+        && writePadded(file, reinterpret_cast<const char *>(directoryTimes.constData()),
+                       static_cast<qint64>(directoryTimes.size()) * sizeof(DirectoryTime));
+
+    if (!written) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool ScanSnapshot::open(const QString &filePath)
+{
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(SnapshotHeader))) {
+        return false;
+    }
+
+    mapped = file.map(0, fileSize);
+    if (!mapped) {
+        return false;
+    }
+
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *>(mapped);
+    if (std::memcmp(header->magic, SnapshotMagic, sizeof(header->magic)) != 0
+        || header->version != SnapshotVersion
+        || header->byteOrder != ByteOrderMark
+        || header->nodeSize != sizeof(DirectoryTreeModel::Node)
+        || header->nodeCount == 0) {
+        return false;
+    }
+
+    // 计算各段偏移并确认都在文件范围内
+    const quint64 rootOffset = alignTo8(sizeof(SnapshotHeader));
+    const quint64 nodeOffset = alignTo8(rootOffset + header->rootPathBytes);
+    const quint64 nameOffset = alignTo8(nodeOffset + quint64(header->nodeCount) * sizeof(DirectoryTreeModel::Node));
+    const quint64 timeOffset = alignTo8(nameOffset + header->nameBytes);
+    const quint64 endOffset = timeOffset + quint64(header->directoryTimeCount) * sizeof(DirectoryTime);
+    if (endOffset > static_cast<quint64>(fileSize) || header->nodeCount > quint32(INT_MAX)) {
+        return false;
+    }
+
+    root = QString::fromUtf8(reinterpret_cast<const char *>(mapped + rootOffset), header->rootPathBytes);
+    nodeData = reinterpret_cast<const DirectoryTreeModel::Node *>(mapped + nodeOffset);
+    nodeTotal = static_cast<int>(header->nodeCount);
+    nameData = reinterpret_cast<const char *>(mapped + nameOffset);
+    nameSize = header->nameBytes;
+    timeData = reinterpret_cast<const DirectoryTime *>(mapped + timeOffset);
+    timeTotal = static_cast<int>(header->directoryTimeCount);
+
+    // 损坏的快照不能交给模型，逐个检查下标和名称范围
+    for (int i = 0; i < nodeTotal; ++i) {
+        const DirectoryTreeModel::Node &node = nodeData[i];
+        const bool parentValid = (i == 0) ? node.parent == -1 : (node.parent >= 0 && node.parent < i);
+        const bool childrenValid = node.childCount == 0
+                                   || (node.firstChild > i && node.childCount > 0
+                                       && qint64(node.firstChild) + node.childCount <= nodeTotal);
+        const bool nameValid = quint64(node.nameOffset) + node.nameLength <= nameSize;
+        if (!parentValid || !childrenValid || !nameValid) {
+            return false;
+        }
+        for (int c = 0; c < node.childCount; ++c) {
+            if (nodeData[node.firstChild + c].parent != i) {
+                return false;
+            }
+        }
+    }
+    for (int i = 0; i < timeTotal; ++i) {
+        if (timeData[i].node < 0 || timeData[i].node >= nodeTotal) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString ScanSnapshot::rootPath() const
+{
+    return root;
+}
+
+const DirectoryTreeModel::Node *ScanSnapshot::nodes() const
+{
+    return nodeData;
+}
+
+int ScanSnapshot::nodeCount() const
+{
+    return nodeTotal;
+}
+
+const char *ScanSnapshot::names() const
+{
+    return nameData;
+}
+
+quint32 ScanSnapshot::nameBytes() const
+{
+    return nameSize;
+}
+
+const ScanSnapshot::DirectoryTime *ScanSnapshot::directoryTimes() const
+{
+    return timeData;
+}
+
+int ScanSnapshot::directoryTimeCount() const
+{
+    return timeTotal;
+}
@@ -0,0 +1,138 @@
+#include "substringautomaton.h"
+#include "literalset.h"
+
+#include <QMap>
+
+#include <deque>
+
+namespace {
+// 合并两个值，保留较小的非负值
+int mergeValue(int a, int b)
+{
+    if (a < 0) {
+        return b;
+    }
+    return (b < 0 || a < b) ? a : b;
+}
+}
+
+void SubstringAutomaton::add(QStringView literal, int value, bool directoryOnly)
+{
+    patterns.append(Pattern{LiteralSet::foldCase(literal), value, directoryOnly});
+}
+
+void SubstringAutomaton::build()
+{
+    // 先建立字典树，子节点用有序映射，展开后同一状态的转移自然按字符排列
+    QVector<QMap<char16_t, int>> children(1);
+    nodes = QVector<Node>(1);
+    for (const Pattern &pattern : patterns) {
+        int state = 0;
+        for (const QChar c : pattern.literal) {
+            auto it = children[state].constFind(c.unicode());
+            if (it == children[state].constEnd()) {
+                const int next = static_cast<int>(nodes.size());
+                children[state].insert(c.unicode(), next);
+                children.append(QMap<char16_t, int>());
+                nodes.append(Node());
+                state = next;
+            } else {
+                state = it.value();
+            }
+        }
+        nodes[state].anyValue = mergeValue(nodes[state].anyValue, pattern.value);
+        if (!pattern.directoryOnly) {
+            nodes[state].fileValue = mergeValue(nodes[state].fileValue, pattern.value);
+        }
+    }
+
+    // 按广度优先顺序计算失败链接，并把失败链接上的结果合并到每个状态
+    edges.clear();
+    std::deque<int> queue;
+    queue.push_back(0);
+    while (!queue.empty()) {
+        const int state = queue.front();
+        queue.pop_front();
+
+        nodes[state].firstEdge = static_cast<int>(edges.size());
+        nodes[state].edgeCount = static_cast<int>(children.at(state).size());
+        for (auto it = children.at(state).constBegin(); it != children.at(state).constEnd(); ++it) {
+            const char16_t c = it.key();
+            const int next = it.value();
+            edges.append(Edge{c, next});
+
+            int fail = 0;
+            if (state != 0) {
+                for (int candidate = nodes.at(state).fail;; candidate = nodes.at(candidate).fail) {
+                    const auto target = children.at(candidate).constFind(c);
+                    if (target != children.at(candidate).constEnd()) {
+                        fail = target.value();
+                        break;
+                    }
+                    if (candidate == 0) {
+                        break;
+                    }
+                }
+            }
+            Node &node = nodes[next];
+            node.fail = fail;
+            node.anyValue = mergeValue(node.anyValue, nodes.at(fail).anyValue);
+            node.fileValue = mergeValue(node.fileValue, nodes.at(fail).fileValue);
+            queue.push_back(next);
+        }
+    }
+    patterns.clear();
+}
+
+bool SubstringAutomaton::isEmpty() const
+{
+    return nodes.size() <= 1 && (nodes.isEmpty() || nodes.at(0).anyValue < 0);
+}
+
+int SubstringAutomaton::find(QStringView folded, bool isDirectory) const
+{
+    if (nodes.isEmpty()) {
+        return -1;
+    }
+
+    // 空模式在初始状态结束，匹配任何文本
+    int state = 0;
+    int value = isDirectory ? nodes.at(0).anyValue : nodes.at(0).fileValue;
+    for (qsizetype i = 0; value < 0 && i < folded.size(); ++i) {
+        const char16_t c = folded.at(i).unicode();
+        for (;;) {
+            const int next = transition(state, c);
+            if (next >= 0) {
+                state = next;
+                break;
+            }
+            if (state == 0) {
+                break;
+            }
+            state = nodes.at(state).fail;
+        }
+        value = isDirectory ? nodes.at(state).anyValue : nodes.at(state).fileValue;
+    }
+    return value;
+}
+
+int SubstringAutomaton::transition(int state, char16_t c) const
+{
+    // 转移按字符升序排列，二分查找
+    const Node &node = nodes.at(state);
+    int low = node.firstEdge;
+    int high = node.firstEdge + node.edgeCount;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        const char16_t key = edges.at(middle).c;
+        if (key == c) {
+            return edges.at(middle).target;
+        }
+        if (key < c) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,141 @@
+#include "directorytreemodel.h"
+
+#include <QtTest>
+
+/**
+ * @class TestDirectoryTreeModel
+ * @brief 目录树模型的排序测试
+ */
+class TestDirectoryTreeModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sortBySizeRollup();
+    void resortWhenRollupCompletes();
+
+private:
+    /**
+     * @brief 追加一个子节点
+     * @param model 模型（用于取得当前的节点数和字符串区大小）
+     * @param batch 节点批次
+     * @param parent 父节点下标
+     * @param name 名称
+     * @param isDir 是否为目录
+     * @return 新节点的下标
+     */
+    static int appendNode(const DirectoryTreeModel &model, DirectoryTreeModel::NodeBatch &batch,
+                          int parent, const QByteArray &name, bool isDir);
+
+    /**
+     * @brief 按行号列出目录下已公开的子节点名称
+     * @param model 模型
+     * @param parent 目录索引
+     * @return 名称列表
+     */
+    static QStringList rowNames(const DirectoryTreeModel &model, const QModelIndex &parent);
+};
+
+int TestDirectoryTreeModel::appendNode(const DirectoryTreeModel &model, DirectoryTreeModel::NodeBatch &batch,
+                                       int parent, const QByteArray &name, bool isDir)
+{
+    DirectoryTreeModel::Node node;
+    node.parent = parent;
+    node.firstChild = -1;
+    node.childCount = 0;
+    node.nameOffset = model.nameBytes() + static_cast<quint32>(batch.names.size());
+    node.nameLength = static_cast<quint16>(name.size());
+    node.flags = isDir ? DirectoryTreeModel::DirectoryFlag : 0;
+    node.reserved = 0;
+
+    batch.nodes.append(node);
+    batch.names.append(name);
+    return model.nodeCount() + batch.nodes.size() - 1;
+}
+
+QStringList TestDirectoryTreeModel::rowNames(const DirectoryTreeModel &model, const QModelIndex &parent)
+{
+    QStringList names;
+    for (int row = 0; row < model.rowCount(parent); ++row) {
+        names.append(model.nodeName(model.nodeFromIndex(model.index(row, 0, parent))));
+    }
+    return names;
+}
+
+void TestDirectoryTreeModel::sortBySizeRollup()
+{
+    // root/{a/d(300), b(100), c(500)}，子节点按名称顺序存放
+    DirectoryTreeModel model;
+    model.resetRoot("root", "/root");
+
+    DirectoryTreeModel::NodeBatch batch;
+    const int a = appendNode(model, batch, 0, "a", true);
+    appendNode(model, batch, 0, "b", false);
+    appendNode(model, batch, 0, "c", false);
+    const int d = appendNode(model, batch, a, "d", false);
+    batch.listings.append(DirectoryTreeModel::Listing{0, a, 3});
+    batch.listings.append(DirectoryTreeModel::Listing{a, d, 1});
+    batch.rollups.append(DirectoryTreeModel::Rollup::unknown());
+    batch.rollups.append(DirectoryTreeModel::Rollup::file(100, 0));
+    batch.rollups.append(DirectoryTreeModel::Rollup::file(500, 0));
+    batch.rollups.append(DirectoryTreeModel::Rollup::file(300, 0));
+    batch.completedRollups.append(DirectoryTreeModel::RollupUpdate{a, DirectoryTreeModel::Rollup{1, 300, 0}});
+    batch.completedRollups.append(DirectoryTreeModel::RollupUpdate{0, DirectoryTreeModel::Rollup{3, 900, 0}});
+    model.appendBatch(batch);
+
+    const QModelIndex root = model.index(0, 0);
+    QVERIFY(model.canFetchMore(root));
+    model.fetchMore(root);
+    QCOMPARE(rowNames(model, root), QStringList({"a", "b", "c"}));
+
+    // 持久索引随排序移到新的行
+    const QPersistentModelIndex persistentC = model.index(2, 0, root);
+
+    model.sort(DirectoryTreeModel::SizeColumn, Qt::DescendingOrder);
+    QCOMPARE(rowNames(model, root), QStringList({"c", "a", "b"}));
+    QCOMPARE(persistentC.row(), 0);
+    QCOMPARE(model.nodeFromIndex(model.parent(model.index(1, 0, root))), 0);
+
+    model.sort(DirectoryTreeModel::SizeColumn, Qt::AscendingOrder);
+    QCOMPARE(rowNames(model, root), QStringList({"b", "a", "c"}));
+    QCOMPARE(persistentC.row(), 2);
+
+    // 恢复按名称排序
+    model.sort(DirectoryTreeModel::NameColumn, Qt::AscendingOrder);
+    QCOMPARE(rowNames(model, root), QStringList({"a", "b", "c"}));
+}
+
+void TestDirectoryTreeModel::resortWhenRollupCompletes()
+{
+    // 按大小排序且目录已展开时，子目录的统计晚于文件到达
+    DirectoryTreeModel model;
+    model.resetRoot("root", "/root");
+    model.setScanning(true);
+    model.sort(DirectoryTreeModel::SizeColumn, Qt::DescendingOrder);
+
+    DirectoryTreeModel::NodeBatch first;
+    const int a = appendNode(model, first, 0, "a", true);
+    appendNode(model, first, 0, "b", false);
+    first.listings.append(DirectoryTreeModel::Listing{0, a, 2});
+    first.rollups.append(DirectoryTreeModel::Rollup::unknown());
+    first.rollups.append(DirectoryTreeModel::Rollup::file(100, 0));
+    model.appendBatch(first);
+
+    const QModelIndex root = model.index(0, 0);
+    model.fetchMore(root);
+
+    // 统计未定的目录排在最小的一端
+    QCOMPARE(rowNames(model, root), QStringList({"b", "a"}));
+
+    DirectoryTreeModel::NodeBatch second;
+    const int d = appendNode(model, second, a, "d", false);
+    second.listings.append(DirectoryTreeModel::Listing{a, d, 1});
+    second.rollups.append(DirectoryTreeModel::Rollup::file(700, 0));
+    second.completedRollups.append(DirectoryTreeModel::RollupUpdate{a, DirectoryTreeModel::Rollup{1, 700, 0}});
+    model.appendBatch(second);
+
+    QCOMPARE(rowNames(model, root), QStringList({"a", "b"}));
+}
+
+QTEST_GUILESS_MAIN(TestDirectoryTreeModel)
+#include "test_directorytreemodel.moc"